@@ -26,18 +26,25 @@
 *
 **********************************************************************************************/
 
-//This is the client main for a simple networking game (max 8 players)
+//This is the client main for a simple networking game
 // it starts up a graphical client, connects to a server and runs the game, showing all players
 
 // include raylib
 #include "raylib.h"
 
+// the low level drawing layer under raylib, used to draw all the players in one batch
+#include "rlgl.h"
+
 // include the networking interface
 // we can't direclty include networking in any file that uses raylib.h, so we abstract out the network gameplay to it's own file
 #include "networking.h"
 
+// the most players drawn between checks that the render batch has room, 4 vertices each
+// this is well under the size of the default raylib batch, so one check is enough for each group
+#define PLAYER_DRAW_GROUP 1024
+
 // a list of predefined colors based on the player lost
-Color PlayerColors[MAX_PLAYERS] = { 0 };
+Color PlayerColors[PLAYER_COLOR_COUNT] = { 0 };
 
 void SetColors()
 {
@@ -51,11 +58,47 @@ void SetColors()
     PlayerColors[7] = ORANGE;
 }
 
+// draw a list of players as squares
+// DrawRectangle does a lot of setup for each call, so with thousands of players that is most of the frame
+// instead every player is added to the render batch as one quad, and the batch is drawn in as few draw calls as it can
+void DrawPlayers(const PlayerDrawItem* items, int count)
+{
+    for (int start = 0; start < count; start += PLAYER_DRAW_GROUP)
+    {
+        int end = start + PLAYER_DRAW_GROUP < count ? start + PLAYER_DRAW_GROUP : count;
+
+        // flush the batch now if this group would not fit, so it is not flushed in the middle of a quad
+        rlCheckRenderBatchLimit((end - start) * 4);
+
+        rlBegin(RL_QUADS);
+        for (int i = start; i < end; i++)
+        {
+            float x = items[i].Position.x;
+            float y = items[i].Position.y;
+            Color color = PlayerColors[items[i].ColorIndex];
+
+            rlColor4ub(color.r, color.g, color.b, color.a);
+            rlVertex2f(x, y);
+            rlVertex2f(x, y + PlayerSize);
+            rlVertex2f(x + PlayerSize, y + PlayerSize);
+            rlVertex2f(x + PlayerSize, y);
+        }
+        rlEnd();
+    }
+}
+
 // main game client
-int main()
+// pass --network-thread to service the network on its own thread instead of in the frame loop
+int main(int argc, char* argv[])
 {
     SetColors();
 
+    for (int i = 1; i < argc; i++)
+    {
+        if (TextIsEqual(argv[i], "--network-thread"))
+            SetNetworkThread(true);
+    }
+
     // set up raylib
     InitWindow(FieldSizeWidth, FieldSizeHeight, "Client");
     SetTargetFPS(60);
@@ -65,8 +108,9 @@ int main()
     Connect();
 
     // how fast in pixels per second we can move
+    // this is shared with the server, since movement is sent as just a direction at this speed
     // NOTE : the server should send us all this data in a real game
-    float moveSpeed = 200;
+    float moveSpeed = PlayerMoveSpeed;
 
     while (!WindowShouldClose())
     {
@@ -117,17 +161,17 @@ int main()
         else
         {
             // we are connected, and know what our player ID is, so show that to the player in our color
-            DrawText(TextFormat("Player %d", GetLocalPlayerId()), 0, 20, 20, PlayerColors[GetLocalPlayerId()]);
-
-            // draw all active players, this includes our local player since the game system is maintaining the local simulation
-            for (int i = 0; i < MAX_PLAYERS; i++)
-            {
-                Vector2 pos = { 0 };
-                if (GetPlayerPos(i, &pos))
-                {
-                    DrawRectangle((int)pos.x, (int)pos.y, PlayerSize, PlayerSize, PlayerColors[i]);
-                }
-            }
+            DrawText(TextFormat("Player %d", GetLocalPlayerId()), 0, 20, 20, PlayerColors[GetLocalPlayerId() % PLAYER_COLOR_COUNT]);
+
+            // if we can't keep up with the server, show how far behind we are
+            if (GetNetworkBacklog() > 0)
+                DrawText(TextFormat("Backlog %d", GetNetworkBacklog()), 0, 40, 20, RED);
+
+            // draw all active players that are on screen, this includes our local player since the game system is maintaining the local simulation
+            // players are drawn down and to the right of their position, so ones just off the top or left of the window still show
+            int count = 0;
+            const PlayerDrawItem* players = GetVisiblePlayers(-PlayerSize, -PlayerSize, (float)GetScreenWidth(), (float)GetScreenHeight(), &count);
+            DrawPlayers(players, count);
         }
         DrawFPS(0, 0);
         EndDrawing();
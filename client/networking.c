@@ -40,6 +40,18 @@
 #define ENET_IMPLEMENTATION
 #include "enet.h"
 
+// the packet functions shared with the server
+#include "packet_io.h"
+
+// the arrays we work out where to draw remote players with
+#include "remote_store.h"
+
+// the network thread and the queues it talks to the game with
+#include "threading.h"
+#include "spsc_queue.h"
+
+#include <math.h>
+
 // the player id of this client
 int LocalPlayerId = -1;
 
@@ -62,6 +74,196 @@ double InputUpdateInterval = 1.0f / 20.0f;
 
 double LastNow = 0;
 
+// how long (in milliseconds) each frame can spend processing network events, 0 means no limit
+// anything left over is processed next frame, so a burst of packets can't stall drawing
+int NetworkTimeBudget = DEFAULT_NETWORK_TIME_BUDGET;
+
+// how many received messages were still waiting to be processed at the end of the last update
+int NetworkBacklog = 0;
+
+// our clock (enet_time_get) when the event being handled was received, time responses are measured against this
+enet_uint32 ReceiveTime = 0;
+
+// the round trip time enet had measured for the connection when the event being handled was received
+// the peer belongs to the network thread when there is one, so it is read there and passed along with the event
+enet_uint32 ReceiveRoundTripTime = 0;
+
+// the network thread
+// when it is used, it owns the enet host and services it every NETWORK_THREAD_INTERVAL milliseconds, no matter how long frames take
+// so acknowledgements go out on time and a slow frame does not hold up the network, or the other way around
+// it hands everything it receives to the game through one queue, and sends what the game gives it from the others
+// all the game state stays on the game thread, the network thread only sees the messages in the queues
+
+// how long (in milliseconds) the network thread waits for packets each time it services the host
+#define NETWORK_THREAD_INTERVAL 1
+
+// how many items each queue to and from the network thread can hold
+#define NETWORK_QUEUE_SIZE 1024
+
+// true if Connect should start a network thread, and true while one is running
+bool NetworkThreadEnabled = false;
+bool NetworkThreadActive = false;
+
+// the network thread, it runs until this is cleared
+Thread NetworkThread = { 0 };
+volatile uint32_t NetworkThreadRunning = 0;
+
+// an event the network thread got from enet, when it got it, and the round trip time of the connection then
+typedef struct
+{
+    ENetEventType Type;
+    ENetPacket* Packet;
+    enet_uint32 Time;
+    enet_uint32 RoundTripTime;
+}InboundMessage;
+
+// a packet for the network thread to send
+typedef struct
+{
+    ENetPacket* Packet;
+    uint8_t Channel;
+}OutboundMessage;
+
+// the queues between the game and the network thread
+SpscQueue InboundQueue = { 0 };     // events from the network thread to the game
+SpscQueue OutboundQueue = { 0 };    // packets from the game to the network thread
+SpscQueue InputQueue = { 0 };       // inputs and what we have acknowledged, from the game to the network thread
+
+// the state of one player as it was in a world update, this is exactly what the server sent
+typedef struct
+{
+    bool Valid;
+
+    int16_t X;
+    int16_t Y;
+    int16_t DX;
+    int16_t DY;
+}PlayerState;
+
+// one world update from the server, it has room for PlayerCapacity players
+typedef struct
+{
+    uint32_t Tick;
+    PlayerState* Players;
+}WorldState;
+
+// the recent world updates we got, indexed by tick % SNAPSHOT_HISTORY
+WorldState Snapshots[SNAPSHOT_HISTORY] = { 0 };
+
+// the tick of the last world update we got, this is sent back to the server with our input
+uint32_t LastSnapshotTick = 0;
+
+// true if the server moves us from our inputs, the server tells us this when we are accepted
+// when it does, we predict where it will put us so our controls don't have to wait for the server
+bool AuthoritativeMovement = false;
+
+// one of our inputs, what direction we wanted to go and for how long
+typedef struct
+{
+    uint8_t Direction;
+    uint8_t Duration;       // in milliseconds
+}PlayerInput;
+
+// our inputs that the server has not processed yet, indexed by sequence number % INPUT_HISTORY
+PlayerInput InputHistory[INPUT_HISTORY] = { 0 };
+
+// what the game tells the network thread about our movement, so it can send our inputs on its own schedule
+typedef struct
+{
+    uint32_t AckTick;       // the last world update we got
+    uint16_t AckedInput;    // the last input the server processed
+    uint16_t NextInput;     // the sequence number the next input will get
+    bool HasInput;          // true if this has a new input, with the sequence number NextInput - 1
+    PlayerInput Input;
+}InputMessage;
+
+// the sequence number the next input will get, and the last one the server told us it processed
+uint16_t NextInput = 1;
+uint16_t LastAckedInput = 0;
+
+// where the server had us after the last input it processed, we replay the newer inputs from here
+int16_t ServerX = 0;
+int16_t ServerY = 0;
+
+// the input we are building, it is finished when the direction changes, it gets too long, or we send our inputs
+uint8_t CurrentDirection = 0;
+double CurrentInputTime = 0;
+
+// how long a server tick is in seconds, the server tells us this when we are accepted
+double ServerTickInterval = 1.0 / 20.0;
+
+// remote players are drawn this far (in seconds) in the past, so there is almost always a newer state to move them toward
+// the measured jitter is added to this, so a choppy connection gets more time
+double InterpolationDelay = DEFAULT_INTERPOLATION_DELAY;
+
+// how far the local clock is ahead of the server tick clock, smoothed over many world updates
+// this includes how long updates take to get to us, which is what we want, we draw relative to when updates show up
+double ClockOffset = 0;
+bool ClockOffsetValid = false;
+
+// how much world updates vary from when we expect them (in seconds), smoothed the same way RTP does it (RFC 3550)
+double Jitter = 0;
+
+// the delay we are drawing with right now, this moves slowly toward the target so players don't jump when it changes
+double CurrentDelay = DEFAULT_INTERPOLATION_DELAY;
+
+// the server time (from ticks) that remote players were drawn at last frame
+double RenderTime = 0;
+
+// how many time request answers we keep, the one that took the least time to come back is the most accurate
+#define TIME_SAMPLES 8
+
+// how often (in seconds) we ask the server what time it is, quickly until we have all our samples and then slowly to track drift
+#define TIME_SYNC_FAST_INTERVAL 0.1
+#define TIME_SYNC_INTERVAL 2.0
+
+// one answer from the server about what time it is
+typedef struct
+{
+    double Offset;          // the server clock minus our clock, in milliseconds
+    double RoundTrip;       // how long the answer took to come back, in milliseconds
+}TimeSample;
+
+// the server clock, worked out NTP style from time requests, our clock (enet_time_get) plus the offset is the server clock
+double ServerClockOffset = 0;
+double RoundTripTime = 0;
+
+// the last time requests that were answered, and where the next one goes
+TimeSample TimeSamples[TIME_SAMPLES] = { 0 };
+int TimeSampleCount = 0;
+int NextTimeSample = 0;
+
+// when (in local seconds) to send the next time request
+double NextTimeRequest = 0;
+
+// a tick and the server clock when it ran, ticks run on a fixed schedule so we can work out any other tick from this
+uint32_t SyncTick = 0;
+uint32_t SyncTickTime = 0;
+
+// the tick of the newest correction we used, older ones that show up late are ignored
+uint32_t LastCorrectionTick = 0;
+
+// world updates that don't fit in one datagram come in parts, this is the update we are putting together
+// it is built in its place in Snapshots, but its tick is not set until all the parts are in, so it can't be used before then
+uint32_t PendingTick = 0;
+uint32_t PendingParts = 0;      // one bit for each part we got
+int PendingPartCount = 0;       // 0 until we get the last part
+
+// how many states from the server we keep for each remote player to draw them between
+#define REMOTE_STATE_HISTORY 8
+
+// the longest (in seconds) we keep moving a remote player past the last state we got for them
+// if updates stop coming, they stop instead of running off across the field
+#define MAX_EXTRAPOLATION 0.25
+
+// one state of a remote player from a world update, and the server time it was for
+typedef struct
+{
+    double Time;
+    Vector2 Position;
+    Vector2 Direction;
+}RemoteState;
+
 // Data about players
 typedef struct
 {
@@ -74,174 +276,953 @@ typedef struct
     // the direction they were going
     Vector2 Direction;
 
-    // the time we got the last update
-    double UpdateTime;
-
-    //where we think this item is right now based on the movement vector
-    Vector2 ExtrapolatedPosition;
+    // the server tick they were added to our simulation, world updates from before this are about an old player in this slot
+    uint32_t AddedTick;
 
+    // the last few states we got for this player, oldest first
+    RemoteState States[REMOTE_STATE_HISTORY];
+    int StateCount;
 
+    // where this player is in RemotePlayers, only set for active remote players
+    int RenderIndex;
 }RemotePlayer;
 
 // The list of all possible players
 // this is the local simulation that represents the current game state
 // it includes the current local player and the last known data from all remote players
 // the client checks this every frame to see where everyone is on the field
-RemotePlayer Players[MAX_PLAYERS] = { 0 };
+// this grows as the server tells us about players with higher ids, so it has room for PlayerCapacity players
+RemotePlayer* Players = NULL;
+int PlayerCapacity = 0;
+
+// the active remote players, packed together with what we need to draw them a little in the past between two states from the server
+// only the players in here are looked at each frame, so it does not matter how many ids the server has handed out
+RemoteStore RemotePlayers = { 0 };
 
-// All the different commands that can be sent over the network
-typedef enum
+// the server time that the times in RemotePlayers are from, so they are small enough to be floats
+double RemoteTimeBase = 0;
+
+// the list of players that GetVisiblePlayers gives out, it has room for the local player and every active remote player
+PlayerDrawItem* DrawItems = NULL;
+int DrawItemCapacity = 0;
+
+// make sure the local simulation has room for a player id, growing it if needed
+// returns false if the id is not valid or we are out of memory
+bool EnsurePlayerCapacity(int id)
 {
-    // Server -> Client, You have been accepted. Contains the id for the client player to use
-    AcceptPlayer = 1,
+    if (id < 0 || id >= MAX_PLAYERS)
+        return false;
 
-    // Server -> Client, Add a new player to your simulation, contains the ID of the player and a position
-    AddPlayer = 2,
+    if (id < PlayerCapacity)
+        return true;
 
-    // Server -> Client, Remove a player from your simulation, contains the ID of the player to remove
-    RemovePlayer = 3,
+    // grow by at least double so that we don't do this for every new player
+    int capacity = PlayerCapacity * 2;
+    if (capacity < id + 1)
+        capacity = id + 1;
+    if (capacity < 8)
+        capacity = 8;
+    if (capacity > MAX_PLAYERS)
+        capacity = MAX_PLAYERS;
 
-    // Server -> Client, Update a player's position in the simulation, contains the ID of the player and a position
-    UpdatePlayer = 4,
+    RemotePlayer* players = (RemotePlayer*)realloc(Players, sizeof(RemotePlayer) * capacity);
+    if (players == NULL)
+        return false;
+
+    memset(players + PlayerCapacity, 0, sizeof(RemotePlayer) * (capacity - PlayerCapacity));
+    Players = players;
 
-    // Client -> Server, Provide an updated location for the client's player, contains the postion to update
-    UpdateInput = 5,
-}NetworkCommands;
+    // every world update we remember needs the same room
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+    {
+        PlayerState* states = (PlayerState*)realloc(Snapshots[i].Players, sizeof(PlayerState) * capacity);
+        if (states == NULL)
+            return false;
+
+        memset(states + PlayerCapacity, 0, sizeof(PlayerState) * (capacity - PlayerCapacity));
+        Snapshots[i].Players = states;
+    }
+
+    PlayerCapacity = capacity;
+    return true;
+}
+
+void StartNetworkThread();
+void StopNetworkThread();
 
 // Connect to a server
 void Connect()
 {
+    // a network thread from an old connection has nothing left to do
+    StopNetworkThread();
+
     // startup the network library
     enet_initialize();
 
     // create a client that we will use to connect to the server
-    client = enet_host_create(NULL, 1, 1, 0, 0);
+    client = enet_host_create(NULL, 1, CHANNEL_COUNT, 0, 0);
     
     // set the address and port we will connect to
     enet_address_set_host(&address, "127.0.0.1");
-    address.port = 4545;
+    address.port = SERVER_PORT;
+
+    // start the connection process. Will be finished as part of our update, or by the network thread
+    server = enet_host_connect(client, &address, CHANNEL_COUNT, 0);
+
+    if (NetworkThreadEnabled && server != NULL)
+        StartNetworkThread();
+}
 
-    // start the connection process. Will be finished as part of our update
-    server = enet_host_connect(client, &address, 1, 0);
+// send a packet to the server, or give it to the network thread to send
+void SendToServer(ENetPacket* packet, uint8_t channel)
+{
+    if (!NetworkThreadActive)
+    {
+        enet_peer_send(server, channel, packet);
+        return;
+    }
+
+    // if the network thread is that far behind, this packet would be late anyway
+    OutboundMessage message = { packet, channel };
+    if (!SpscQueuePush(&OutboundQueue, &message))
+        enet_packet_destroy(packet);
 }
 
-// Utility functions to read data out of a packet
-// Optimally this would go into a library that was shared by the client and the server
+// send every input the server has not processed yet, so if this is lost the next one will have them too
+// this is used by the game thread, and by the network thread with its own copy of the inputs
+void SendMoveInput(ENetPeer* peer, const PlayerInput* history, uint16_t nextInput, uint16_t ackedInput, uint32_t ackTick)
+{
+    int count = (uint16_t)(nextInput - ackedInput - 1);
+    if (count > INPUT_HISTORY)
+        count = INPUT_HISTORY;
+
+    // 8 bytes for the command, the last world update tick, the first sequence number and the count,
+    // and 12 bits for each input
+    PacketWriter writer;
+    if (!PacketWriterBegin(&writer, 8 + (count * 12 + 7) / 8, 0))
+        return;
+
+    WriteByte(&writer, (uint8_t)MoveInput);
+    WriteInt(&writer, ackTick);
+    WriteUShort(&writer, (uint16_t)(nextInput - count));
+    WriteByte(&writer, (uint8_t)count);
+
+    for (uint16_t sequence = (uint16_t)(nextInput - count); sequence != nextInput; sequence++)
+    {
+        WriteBits(&writer, history[sequence % INPUT_HISTORY].Direction, DIRECTION_BITS);
+        WriteBits(&writer, history[sequence % INPUT_HISTORY].Duration, 8);
+    }
+
+    ENetPacket* packet = PacketWriterEnd(&writer);
+    if (packet != NULL)
+        enet_peer_send(peer, CHANNEL_UNRELIABLE, packet);
+}
 
 /// <summary>
-/// Read one byte out of a packet, from an offset, and update that offset to the next location to read from
+/// Read a bit packed player position and direction from the network packet
+/// positions are sent with just enough bits to cover the field and converted into floats for display
+/// directions are sent as one of 8 directions at the player move speed
 /// </summary>
-/// <param name="packet">The packet to read from</param>
-/// <param name="offset">A pointer to an offset that is updated, this should be passed to other read functions so they read from the correct place</param>
-/// <returns>The byte read</returns>
-uint8_t ReadByte(ENetPacket* packet, size_t* offset)
+/// <param name="reader">The reader for the packet</param>
+/// <param name="position">The position that was read</param>
+/// <param name="direction">The movement direction that was read</param>
+void ReadMovement(PacketReader* reader, Vector2* position, Vector2* direction)
 {
-    // make sure we have not gone past the end of the data we were sent
-    if (*offset > packet->dataLength)
-        return 0;
+    position->x = (float)ReadBits(reader, POSITION_X_BITS);
+    position->y = (float)ReadBits(reader, POSITION_Y_BITS);
 
-    // cast the data to a byte so we can increment it in 1 byte chunks
-    uint8_t* ptr = (uint8_t*)packet->data;
+    int16_t dx = 0, dy = 0;
+    DecodeDirection((uint8_t)ReadBits(reader, DIRECTION_BITS), &dx, &dy);
+    direction->x = dx;
+    direction->y = dy;
+}
+
+// pick the two states a remote player is drawn between at a render time, and give them to RemotePlayers
+// this is the first state that is not before the render time and the one before it
+// if there isn't one, the newest state is used on its own and the player keeps going from there
+void SelectSegment(int id, float renderTime)
+{
+    RemotePlayer* player = &Players[id];
+    if (player->StateCount == 0)
+        return;
 
-    // get the byte at the current offset
-    uint8_t data = ptr[(*offset)];
+    int to = 0;
+    while (to < player->StateCount && (float)(player->States[to].Time - RemoteTimeBase) < renderTime)
+        to++;
 
-    // move the offset over 1 byte for the next read
-    *offset = *offset + 1;
+    int from = to > 0 ? to - 1 : 0;
+    if (to == player->StateCount)
+        from = to = player->StateCount - 1;
 
-    return data;
+    const RemoteState* fromState = &player->States[from];
+    const RemoteState* toState = &player->States[to];
+    RemoteStoreSetSegment(&RemotePlayers, player->RenderIndex,
+        (float)(fromState->Time - RemoteTimeBase), fromState->Position.x, fromState->Position.y,
+        (float)(toState->Time - RemoteTimeBase), toState->Position.x, toState->Position.y,
+        toState->Direction.x, toState->Direction.y);
 }
 
-/// <summary>
-/// Read a signed short from the network packet
-/// Note that this assumes the packet is in the host's byte ordering
-/// In reality read/write code should use ntohs and htons to convert from network byte order to host byte order, so both big endian and little endian machines can play together
-/// </summary>
-/// <param name="packet">The packet to read from<</param>
-/// <param name="offset">A pointer to an offset that is updated, this should be passed to other read functions so they read from the correct place</param>
-/// <returns>The signed short that is read</returns>
-int16_t ReadShort(ENetPacket* packet, size_t* offset)
+// add a state from the server to a remote player
+// states always go forward in time, so anything older than the newest one we have is dropped
+void PushRemoteState(int id, double time, Vector2 position, Vector2 direction)
 {
-    // make sure we have not gone past the end of the data we were sent
-    if (*offset > packet->dataLength)
-        return 0;
+    RemotePlayer* player = &Players[id];
+    if (player->StateCount > 0)
+    {
+        RemoteState* newest = &player->States[player->StateCount - 1];
+        if (time < newest->Time)
+            return;
 
-    // cast the data to a byte at the offset
-    uint8_t* data = (uint8_t*)packet->data;
-    data += (*offset);
+        // the same time again, just replace it
+        if (time == newest->Time)
+        {
+            newest->Position = position;
+            newest->Direction = direction;
 
-    // move the offset over 2 bytes for the next read
-    *offset = (*offset) + 2;
+            // it may be the one we are drawing them toward
+            SelectSegment(id, (float)(RenderTime - RemoteTimeBase));
+            return;
+        }
+    }
 
-    // cast the data pointer to a short and return a copy
-    return *(int16_t*)data;
+    // full, throw away the oldest one
+    if (player->StateCount == REMOTE_STATE_HISTORY)
+    {
+        memmove(player->States, player->States + 1, sizeof(RemoteState) * (REMOTE_STATE_HISTORY - 1));
+        player->StateCount--;
+    }
+
+    RemoteState* state = &player->States[player->StateCount++];
+    state->Time = time;
+    state->Position = position;
+    state->Direction = direction;
 }
 
-/// <summary>
-/// Read a player position from the network packet
-/// player positions are sent as two signed shorts and converted into floats for display
-/// since this sample does everything in pixels, this is fine, but a more robust game would want to send floats
-/// </summary>
-/// <param name="packet"></param>
-/// <param name="offset"></param>
-/// <returns>A raylib Vector with the position in the data</returns>
-Vector2 ReadPosition(ENetPacket* packet, size_t* offset)
+// see how world updates are arriving compared to the server clock, so we know how far in the past to draw remote players
+void UpdateClock(uint32_t tick)
+{
+    double difference = LastNow - tick * ServerTickInterval;
+
+    if (!ClockOffsetValid)
+    {
+        ClockOffset = difference;
+        ClockOffsetValid = true;
+        Jitter = 0;
+        return;
+    }
+
+    // take a little of each sample, so one late update doesn't move everything
+    double deviation = difference - ClockOffset;
+    ClockOffset += deviation / 16;
+    Jitter += (fabs(deviation) - Jitter) / 16;
+}
+
+// start drawing a remote player
+// returns false if we are out of memory
+bool ActivateRemotePlayer(int id)
 {
-    Vector2 pos = { 0 };
-    pos.x = ReadShort(packet, offset);
-    pos.y = ReadShort(packet, offset);
+    if (Players[id].Active)
+        return true;
 
-    return pos;
+    int index = RemoteStoreAdd(&RemotePlayers, id);
+    if (index < 0)
+        return false;
+
+    Players[id].Active = true;
+    Players[id].RenderIndex = index;
+    return true;
+}
+
+// stop drawing a remote player, the last one in RemotePlayers is moved into their place
+void DeactivateRemotePlayer(int id)
+{
+    if (!Players[id].Active)
+        return;
+
+    int moved = RemoteStoreRemove(&RemotePlayers, Players[id].RenderIndex);
+    if (moved >= 0)
+        Players[moved].RenderIndex = Players[id].RenderIndex;
+
+    Players[id].Active = false;
 }
 
 // functions to handle the commands that the server will send to the client
 // these take the data from enet and read out various bits of data from it to do actions based on the command that was sent
 
 // A new remote player was added to our local simulation
-void HandleAddPlayer(ENetPacket* packet, size_t* offset)
+void HandleAddPlayer(PacketReader* reader)
 {
     // find out who the server is talking about
-    int remotePlayer = ReadByte(packet, offset);
-    if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId)
+    // always read the whole message, even if we skip it, so that the next message in the packet is read from the right place
+    int remotePlayer = ReadUShort(reader);
+    uint32_t addedTick = ReadInt(reader);
+    Vector2 position = { 0 };
+    Vector2 direction = { 0 };
+    ReadMovement(reader, &position, &direction);
+
+    // the message was cut short, so don't trust any of it
+    if (reader->Overflow || remotePlayer == LocalPlayerId || !EnsurePlayerCapacity(remotePlayer))
         return;
 
     // set them as active and update the location
-    Players[remotePlayer].Active = true;
-    Players[remotePlayer].Position = ReadPosition(packet, offset);
-    Players[remotePlayer].Direction = ReadPosition(packet, offset);
-    Players[remotePlayer].UpdateTime = LastNow;
+    // anything we had for this slot was for someone else, so start their states over
+    if (!ActivateRemotePlayer(remotePlayer))
+        return;
+
+    Players[remotePlayer].AddedTick = addedTick;
+    Players[remotePlayer].Position = position;
+    Players[remotePlayer].Direction = direction;
+    Players[remotePlayer].StateCount = 0;
+    PushRemoteState(remotePlayer, addedTick * ServerTickInterval, position, direction);
+    SelectSegment(remotePlayer, (float)(RenderTime - RemoteTimeBase));
+    RemotePlayers.RenderX[Players[remotePlayer].RenderIndex] = position.x;
+    RemotePlayers.RenderY[Players[remotePlayer].RenderIndex] = position.y;
 
     // In a more robust game, this message would have more info about the new player, such as what sprite or model to use, player name, or other data a client would need
     // this is where static data about the player would be sent, and any initial state needed to setup the local simulation
 }
 
 // A remote player has left the game and needs to be removed from the local simulation
-void HandleRemovePlayer(ENetPacket* packet, size_t* offset)
+void HandleRemovePlayer(PacketReader* reader)
 {
-    // find out who the server is talking about
-    int remotePlayer = ReadByte(packet, offset);
-    if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId)
+    // find out who the server is talking about, and when they were removed
+    int remotePlayer = ReadUShort(reader);
+    uint32_t removedTick = ReadInt(reader);
+    if (reader->Overflow || remotePlayer >= PlayerCapacity || remotePlayer == LocalPlayerId)
+        return;
+
+    // this is about an older player in this slot, the new one has already been added
+    if (removedTick < Players[remotePlayer].AddedTick)
         return;
 
     // remove the player from the simulation. No other data is needed except the player id
-    Players[remotePlayer].Active = false;
+    DeactivateRemotePlayer(remotePlayer);
 }
 
-// The server has a new position for a player in our local simulation
-void HandleUpdatePlayer(ENetPacket* packet, size_t* offset)
+// The server has new positions for the players in our local simulation
+// the server sends one update each tick, with only the players that changed since an update we told it we have
+// big updates are split into parts, and the update is only used once all of them are in
+void HandleUpdatePlayer(PacketReader* reader)
 {
-    // find out who the server is talking about
-    int remotePlayer = ReadByte(packet, offset);
-    if (remotePlayer >= MAX_PLAYERS || remotePlayer == LocalPlayerId || !Players[remotePlayer].Active)
+    uint32_t tick = ReadInt(reader);
+
+    // the base is sent as how many ticks older than this update it is
+    uint8_t baseAge = ReadByte(reader);
+    uint32_t baseTick = baseAge != 0 ? tick - baseAge : 0;
+
+    uint8_t part = ReadByte(reader);
+    int partIndex = part & ~UPDATE_PART_LAST;
+
+    // find out how many players the server is talking about in this part
+    int count = ReadUShort(reader);
+
+    // world updates always fill the rest of their packet, so anything we don't use can just be skipped
+    // ignore anything older than what we have, or older than the update we are putting together
+    if (reader->Overflow || tick <= LastSnapshotTick || tick < PendingTick || partIndex >= MAX_UPDATE_PARTS)
+    {
+        PacketReaderSkip(reader);
+        return;
+    }
+
+    WorldState* world = &Snapshots[tick % SNAPSHOT_HISTORY];
+
+    // the first part of a new update we have seen, they can show up in any order
+    if (tick != PendingTick)
+    {
+        // find the update this one is based on, if we don't have it we can't use this update
+        WorldState* base = NULL;
+        if (baseTick != 0)
+        {
+            base = &Snapshots[baseTick % SNAPSHOT_HISTORY];
+            if (base->Tick != baseTick)
+            {
+                PacketReaderSkip(reader);
+                return;
+            }
+        }
+
+        // build the new world from the base, and then change what the server says is different
+        if (base != NULL)
+            memcpy(world->Players, base->Players, sizeof(PlayerState) * PlayerCapacity);
+        else if (PlayerCapacity > 0)
+            memset(world->Players, 0, sizeof(PlayerState) * PlayerCapacity);
+
+        world->Tick = 0;
+        PendingTick = tick;
+        PendingParts = 0;
+        PendingPartCount = 0;
+    }
+    else if (PendingParts & (1u << partIndex))
+    {
+        // we already have this part
+        PacketReaderSkip(reader);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        // find out who the server is talking about and what changed
+        int remotePlayer = ReadVarBits(reader);
+        uint8_t mask = (uint8_t)ReadBits(reader, FIELD_BITS);
+
+        // make room for them if this is the first time we have heard of this id
+        bool validId = EnsurePlayerCapacity(remotePlayer);
+
+        // always read the data, even if we skip this player, so that the next player is read from the right place
+        PlayerState state = { 0 };
+        if (validId)
+            state = world->Players[remotePlayer];
+
+        if (mask & FIELD_X)
+            state.X = (int16_t)ReadBits(reader, POSITION_X_BITS);
+        if (mask & FIELD_Y)
+            state.Y = (int16_t)ReadBits(reader, POSITION_Y_BITS);
+        if (mask & FIELD_DIR)
+            DecodeDirection((uint8_t)ReadBits(reader, DIRECTION_BITS), &state.DX, &state.DY);
+
+        // the message was cut short, so we can't use this update or build on it
+        if (reader->Overflow)
+        {
+            PendingTick = 0;
+            return;
+        }
+
+        // a partial update for someone we don't know about makes no sense
+        if (!validId || (!state.Valid && mask != FIELD_ALL))
+            continue;
+
+        state.Valid = true;
+        world->Players[remotePlayer] = state;
+    }
+
+    PendingParts |= 1u << partIndex;
+    if (part & UPDATE_PART_LAST)
+        PendingPartCount = partIndex + 1;
+
+    // wait for the rest of the parts
+    if (PendingPartCount == 0 || PendingParts != (uint32_t)((1ull << PendingPartCount) - 1))
+        return;
+
+    world->Tick = tick;
+    LastSnapshotTick = tick;
+    UpdateClock(tick);
+
+    double time = tick * ServerTickInterval;
+
+    // update the local simulation with the new world
+    for (int i = 0; i < PlayerCapacity; i++)
+    {
+        const PlayerState* state = &world->Players[i];
+
+        // the server does not tell us about ourselves, we know where we are
+        if (!state->Valid || i == LocalPlayerId || !Players[i].Active)
+            continue;
+
+        // add messages come on a different channel, so this update can be older than when they were added
+        if (world->Tick < Players[i].AddedTick)
+            continue;
+
+        // update the last known position and movement
+        // every player in the world gets a state, even if they did not change, so we know they were still there at this time
+        Players[i].Position = (Vector2){ state->X, state->Y };
+        Players[i].Direction = (Vector2){ state->DX, state->DY };
+        PushRemoteState(i, time, Players[i].Position, Players[i].Direction);
+    }
+}
+
+// how many of our inputs the server has not processed yet, we only remember the last INPUT_HISTORY of them
+int GetPendingInputCount()
+{
+    int count = (uint16_t)(NextInput - LastAckedInput - 1);
+    return count > INPUT_HISTORY ? INPUT_HISTORY : count;
+}
+
+// finish the input we are building and put it in the history, so it is sent to the server
+// any time that does not make a whole millisecond is kept for the next input
+void FinishInput()
+{
+    int duration = (int)(CurrentInputTime * 1000);
+    if (duration <= 0)
+        return;
+
+    if (duration > MAX_INPUT_DURATION)
+        duration = MAX_INPUT_DURATION;
+
+    PlayerInput* input = &InputHistory[NextInput % INPUT_HISTORY];
+    input->Direction = CurrentDirection;
+    input->Duration = (uint8_t)duration;
+
+    NextInput++;
+    CurrentInputTime -= duration / 1000.0;
+
+    // the network thread sends our inputs, so it needs a copy
+    if (NetworkThreadActive)
+    {
+        InputMessage message = { LastSnapshotTick, LastAckedInput, NextInput, true, *input };
+        SpscQueuePush(&InputQueue, &message);
+    }
+}
+
+// work out where the server will put us once it has all our inputs
+// start from where it last told us we were, and move the same way it will for every input it has not processed yet
+// the input we are still building is added on top, so we move smoothly every frame
+void PredictLocalPlayer()
+{
+    int16_t x = ServerX;
+    int16_t y = ServerY;
+
+    int count = GetPendingInputCount();
+    for (uint16_t sequence = (uint16_t)(NextInput - count); sequence != NextInput; sequence++)
+    {
+        const PlayerInput* input = &InputHistory[sequence % INPUT_HISTORY];
+
+        int16_t dx = 0, dy = 0;
+        DecodeDirection(input->Direction, &dx, &dy);
+        x = MoveAxis(x, dx, input->Duration, FieldSizeWidth - PlayerSize);
+        y = MoveAxis(y, dy, input->Duration, FieldSizeHeight - PlayerSize);
+    }
+
+    int16_t dx = 0, dy = 0;
+    DecodeDirection(CurrentDirection, &dx, &dy);
+
+    Vector2 position = { x + dx * (float)CurrentInputTime, y + dy * (float)CurrentInputTime };
+    position.x = (float)QuantizePosition(position.x, FieldSizeWidth - PlayerSize);
+    position.y = (float)QuantizePosition(position.y, FieldSizeHeight - PlayerSize);
+
+    Players[LocalPlayerId].Position = position;
+    Players[LocalPlayerId].Direction = (Vector2){ dx, dy };
+}
+
+// The server has processed some of our inputs and is telling us where they put us
+void HandleCorrectPlayer(PacketReader* reader)
+{
+    uint32_t tick = ReadInt(reader);
+    uint16_t sequence = ReadUShort(reader);
+    int16_t x = (int16_t)ReadBits(reader, POSITION_X_BITS);
+    int16_t y = (int16_t)ReadBits(reader, POSITION_Y_BITS);
+
+    if (reader->Overflow || !AuthoritativeMovement)
         return;
 
-    // update the last known position and movement
-    Players[remotePlayer].Position = ReadPosition(packet, offset);
-    Players[remotePlayer].Direction = ReadPosition(packet, offset);
-    Players[remotePlayer].UpdateTime = LastNow;
+    // these come with world updates, so they can show up out of order, only take newer ones
+    // and it can't be for an input we have not made yet
+    if (tick < LastCorrectionTick || (int16_t)(sequence - LastAckedInput) < 0 || (int16_t)(sequence - NextInput) >= 0)
+        return;
 
-    // in a more robust game this message would have a tick ID for what time this information was valid, and extra info about
-    // what the input state was so the local simulation could do prediction and smooth out the motion
+    LastCorrectionTick = tick;
+    LastAckedInput = sequence;
+    ServerX = x;
+    ServerY = y;
+
+    // replay everything the server has not seen yet on top of where it says we are
+    PredictLocalPlayer();
+}
+
+// remember a tick and when the server ran it, if it is newer than the one we have
+void SetSyncTick(uint32_t tick, uint32_t tickTime)
+{
+    if (tick < SyncTick)
+        return;
+
+    SyncTick = tick;
+    SyncTickTime = tickTime;
+}
+
+// The server answered one of our time requests
+// this works like NTP, we know when we sent the request and when the answer came back, and the server says what its clock was in between
+// assuming the trip took as long each way, the server clock was that when we were half way between sending and getting the answer
+void HandleTimeResponse(PacketReader* reader)
+{
+    uint32_t clientTime = ReadInt(reader);
+    uint32_t serverTime = ReadInt(reader);
+    uint32_t tick = ReadInt(reader);
+    uint32_t tickTime = ReadInt(reader);
+
+    if (reader->Overflow)
+        return;
+
+    // clocks wrap around, so look at the differences as signed numbers
+    double roundTrip = (int32_t)(ReceiveTime - clientTime);
+    if (roundTrip < 0)
+        return;
+
+    TimeSample* sample = &TimeSamples[NextTimeSample];
+    sample->RoundTrip = roundTrip;
+    sample->Offset = (int32_t)(serverTime - clientTime) - roundTrip / 2;
+
+    NextTimeSample = (NextTimeSample + 1) % TIME_SAMPLES;
+    if (TimeSampleCount < TIME_SAMPLES)
+        TimeSampleCount++;
+
+    // the answer that came back the fastest had the least time to be held up on one side of the trip, so trust that one
+    const TimeSample* best = &TimeSamples[0];
+    for (int i = 1; i < TimeSampleCount; i++)
+    {
+        if (TimeSamples[i].RoundTrip < best->RoundTrip)
+            best = &TimeSamples[i];
+    }
+
+    ServerClockOffset = best->Offset;
+    RoundTripTime = best->RoundTrip;
+
+    SetSyncTick(tick, tickTime);
+}
+
+// ask the server what time it is
+// with a network thread this waits in a queue until the thread sends it, which is at most NETWORK_THREAD_INTERVAL
+void SendTimeRequest()
+{
+    PacketWriter writer;
+    if (!PacketWriterBegin(&writer, 5, ENET_PACKET_FLAG_UNSEQUENCED))
+        return;
+
+    WriteByte(&writer, (uint8_t)TimeRequest);
+    WriteInt(&writer, enet_time_get());
+
+    ENetPacket* packet = PacketWriterEnd(&writer);
+    if (packet != NULL)
+        SendToServer(packet, CHANNEL_UNRELIABLE);
+}
+
+// The server has accepted us as a player
+void HandleAcceptPlayer(PacketReader* reader)
+{
+    // See who the server says we are, how it wants our movement, and where we start
+    LocalPlayerId = ReadUShort(reader);
+    uint8_t flags = ReadByte(reader);
+    int tickInterval = ReadUShort(reader);
+    uint32_t serverTime = ReadInt(reader);
+    uint32_t tick = ReadInt(reader);
+    uint32_t tickTime = ReadInt(reader);
+    int16_t x = (int16_t)ReadBits(reader, POSITION_X_BITS);
+    int16_t y = (int16_t)ReadBits(reader, POSITION_Y_BITS);
+
+    // Make sure that it makes sense, and that we have room for it
+    if (reader->Overflow || tickInterval == 0 || !EnsurePlayerCapacity(LocalPlayerId))
+    {
+        LocalPlayerId = -1;
+        return;
+    }
+
+    // start over with our inputs
+    AuthoritativeMovement = (flags & ACCEPT_AUTHORITATIVE) != 0;
+    ServerTickInterval = tickInterval / 1000.0;
+    ClockOffsetValid = false;
+
+    // start with a rough guess at the server clock, using the round trip time enet has measured for the connection
+    // and then ask for better ones right away
+    RoundTripTime = ReceiveRoundTripTime;
+    ServerClockOffset = (int32_t)(serverTime - ReceiveTime) + RoundTripTime / 2;
+    TimeSampleCount = 0;
+    NextTimeSample = 0;
+    NextTimeRequest = 0;
+    SyncTick = 0;
+    SetSyncTick(tick, tickTime);
+    LastCorrectionTick = 0;
+    NextInput = 1;
+    LastAckedInput = 0;
+    ServerX = x;
+    ServerY = y;
+    CurrentDirection = 0;
+    CurrentInputTime = 0;
+
+    // Force the next frame to do an update by pretending it's been a very long time since our last update
+    LastInputSend = -InputUpdateInterval;
+
+    // this is a new connection, so we have no world updates from it yet
+    LastSnapshotTick = 0;
+    PendingTick = 0;
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+    {
+        Snapshots[i].Tick = 0;
+        memset(Snapshots[i].Players, 0, sizeof(PlayerState) * PlayerCapacity);
+    }
+
+    // anyone we knew about was from an old connection
+    for (int i = 0; i < PlayerCapacity; i++)
+        Players[i].Active = false;
+    RemotePlayers.Count = 0;
+    RemoteTimeBase = tick * ServerTickInterval;
+
+    // We are active
+    Players[LocalPlayerId].Active = true;
+
+    // Set our player where the server says we start
+    // optimally we would do a much more robust connection negotiation where we tell the server what our name is, what we look like
+    Players[LocalPlayerId].Position = (Vector2){ x, y };
+    Players[LocalPlayerId].Direction = (Vector2){ 0, 0 };
+}
+
+// process one message from a packet
+// returns false if the message can't be read, so the rest of the packet can't be either
+bool HandleMessage(NetworkCommands command, PacketReader* reader)
+{
+    // if the server has not accepted us yet, we are limited in what messages we can receive
+    if (LocalPlayerId == -1)
+    {
+        // this is the only thing we can do in this state, so ignore anything else
+        if (command != AcceptPlayer)
+            return false;
+
+        HandleAcceptPlayer(reader);
+        return LocalPlayerId != -1;
+    }
+
+    // we have been accepted, so process play messages from the server
+    switch (command)
+    {
+    case AddPlayer:
+        HandleAddPlayer(reader);
+        return true;
+
+    case RemovePlayer:
+        HandleRemovePlayer(reader);
+        return true;
+
+    case UpdatePlayer:
+        HandleUpdatePlayer(reader);
+        return true;
+
+    case CorrectPlayer:
+        HandleCorrectPlayer(reader);
+        return true;
+
+    case TimeResponse:
+        HandleTimeResponse(reader);
+        return true;
+
+    default:
+        // we don't know how big this is, so we can't find the next message
+        return false;
+    }
+}
+
+// process one event from enet
+void HandleNetworkEvent(ENetEvent* event)
+{
+    // see what kind of event it is
+    switch (event->type)
+    {
+    // the server sent us some data, we should process it
+    case ENET_EVENT_TYPE_RECEIVE:
+    {
+        // the reader keeps track of what data we have read so far
+        PacketReader reader;
+        PacketReaderInit(&reader, event->packet);
+
+        // the server batches messages up, so one packet can have many messages in it, one after the other
+        // keep reading until we run out of data, or find a message we can't read past
+        while (!reader.Overflow && reader.Offset < reader.Length)
+        {
+            // read off the command that the server wants us to do
+            NetworkCommands command = (NetworkCommands)ReadByte(&reader);
+            if (!HandleMessage(command, &reader))
+                break;
+        }
+
+        // tell enet that it can recycle the packet data
+        enet_packet_destroy(event->packet);
+        break;
+    }
+
+    // we were disconnected, we have a sad
+    case ENET_EVENT_TYPE_DISCONNECT:
+    case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+        server = NULL;
+        LocalPlayerId = -1;
+        break;
+    }
+}
+
+// process all the events enet has for us, until we run out of them or of time
+// enet_host_service sends what we have queued and reads everything waiting on the socket, but only gives us one event
+// so the rest are drained with enet_host_check_events, which does not touch the socket
+// if we only took one event a frame, a server sending more than 60 packets a second would put us further behind every frame
+void ProcessNetworkEvents()
+{
+    ENetEvent event = { 0 };
+    enet_uint32 start = enet_time_get();
+
+    // the network thread has already received everything, so just take what it has for us
+    if (NetworkThreadActive)
+    {
+        InboundMessage message;
+        while (SpscQueuePop(&InboundQueue, &message))
+        {
+            event.type = message.Type;
+            event.packet = message.Packet;
+            ReceiveTime = message.Time;
+            ReceiveRoundTripTime = message.RoundTripTime;
+            HandleNetworkEvent(&event);
+
+            if (server == NULL)
+                break;
+
+            if (NetworkTimeBudget > 0 && ENET_TIME_DIFFERENCE(enet_time_get(), start) >= (enet_uint32)NetworkTimeBudget)
+                break;
+        }
+
+        NetworkBacklog = server != NULL ? (int)SpscQueueSize(&InboundQueue) : 0;
+        return;
+    }
+
+    // Since this is a a client, we don't set a timeout so that the client can keep going if there are no events
+    int result = enet_host_service(client, &event, 0);
+    while (result > 0)
+    {
+        ReceiveTime = enet_time_get();
+        ReceiveRoundTripTime = enet_peer_get_rtt(event.peer);
+        HandleNetworkEvent(&event);
+
+        // we got disconnected, there is nothing left for us
+        if (server == NULL)
+            break;
+
+        // out of time, the rest will wait for the next frame
+        if (NetworkTimeBudget > 0 && ENET_TIME_DIFFERENCE(enet_time_get(), start) >= (enet_uint32)NetworkTimeBudget)
+            break;
+
+        result = enet_host_check_events(client, &event);
+    }
+
+    // see how much we did not get to, this should be 0 unless we are falling behind
+    NetworkBacklog = server != NULL ? (int)enet_list_size(&server->dispatchedCommands) : 0;
+}
+
+// the network thread
+// it sends what the game gives it, resends our inputs every InputUpdateInterval, and services the host
+// everything it receives goes into the inbound queue for the game, if the game is that far behind it waits for room
+void NetworkThreadMain(void* argument)
+{
+    ENetPeer* peer = (ENetPeer*)argument;
+    bool connected = true;
+
+    // our own copy of the inputs the server has not processed, from the game
+    PlayerInput inputs[INPUT_HISTORY] = { 0 };
+    InputMessage state = { 0 };
+    bool moving = false;
+    enet_uint32 lastInputSend = enet_time_get();
+    enet_uint32 inputInterval = (enet_uint32)(InputUpdateInterval * 1000);
+
+    // an event there was no room for in the inbound queue
+    InboundMessage pending = { 0 };
+    bool hasPending = false;
+
+    while (AtomicLoad(&NetworkThreadRunning))
+    {
+        // send what the game has for the server
+        OutboundMessage outbound;
+        while (SpscQueuePop(&OutboundQueue, &outbound))
+        {
+            if (connected)
+                enet_peer_send(peer, outbound.Channel, outbound.Packet);
+            else
+                enet_packet_destroy(outbound.Packet);
+        }
+
+        // keep our copy of the inputs up to date
+        InputMessage input;
+        while (SpscQueuePop(&InputQueue, &input))
+        {
+            if (input.HasInput)
+                inputs[(uint16_t)(input.NextInput - 1) % INPUT_HISTORY] = input.Input;
+
+            state = input;
+            moving = true;
+        }
+
+        // send our inputs on time, even if the game is having a slow frame
+        enet_uint32 now = enet_time_get();
+        if (connected && moving && ENET_TIME_DIFFERENCE(now, lastInputSend) >= inputInterval)
+        {
+            SendMoveInput(peer, inputs, state.NextInput, state.AckedInput, state.AckTick);
+            lastInputSend = now;
+        }
+
+        // the game has not taken what we have already, so don't get any more until it does
+        if (hasPending)
+        {
+            if (!SpscQueuePush(&InboundQueue, &pending))
+            {
+                enet_host_flush(client);
+                ThreadSleep(NETWORK_THREAD_INTERVAL);
+                continue;
+            }
+            hasPending = false;
+        }
+
+        // wait a little for packets, and pass on everything that came in
+        ENetEvent event = { 0 };
+        int result = enet_host_service(client, &event, NETWORK_THREAD_INTERVAL);
+        while (result > 0)
+        {
+            if (event.type == ENET_EVENT_TYPE_DISCONNECT || event.type == ENET_EVENT_TYPE_DISCONNECT_TIMEOUT)
+                connected = false;
+
+            InboundMessage message = { event.type, event.packet, enet_time_get(), enet_peer_get_rtt(peer) };
+            if (!SpscQueuePush(&InboundQueue, &message))
+            {
+                pending = message;
+                hasPending = true;
+                break;
+            }
+
+            result = enet_host_check_events(client, &event);
+        }
+    }
+
+    if (hasPending && pending.Packet != NULL)
+        enet_packet_destroy(pending.Packet);
+}
+
+// start a network thread for the connection we just started
+// if it can't be started, the game services the host itself like normal
+void StartNetworkThread()
+{
+    if (!SpscQueueInit(&InboundQueue, NETWORK_QUEUE_SIZE, sizeof(InboundMessage))
+        || !SpscQueueInit(&OutboundQueue, NETWORK_QUEUE_SIZE, sizeof(OutboundMessage))
+        || !SpscQueueInit(&InputQueue, NETWORK_QUEUE_SIZE, sizeof(InputMessage)))
+    {
+        SpscQueueFree(&InboundQueue);
+        SpscQueueFree(&OutboundQueue);
+        SpscQueueFree(&InputQueue);
+        return;
+    }
+
+    NetworkThreadRunning = 1;
+    NetworkThreadActive = ThreadStart(&NetworkThread, NetworkThreadMain, server);
+    if (!NetworkThreadActive)
+    {
+        SpscQueueFree(&InboundQueue);
+        SpscQueueFree(&OutboundQueue);
+        SpscQueueFree(&InputQueue);
+    }
+}
+
+// stop the network thread, and throw away anything still in the queues
+void StopNetworkThread()
+{
+    if (!NetworkThreadActive)
+        return;
+
+    AtomicStore(&NetworkThreadRunning, 0);
+    ThreadJoin(&NetworkThread);
+    NetworkThreadActive = false;
+
+    InboundMessage inbound;
+    while (SpscQueuePop(&InboundQueue, &inbound))
+    {
+        if (inbound.Packet != NULL)
+            enet_packet_destroy(inbound.Packet);
+    }
+
+    OutboundMessage outbound;
+    while (SpscQueuePop(&OutboundQueue, &outbound))
+        enet_packet_destroy(outbound.Packet);
+
+    SpscQueueFree(&InboundQueue);
+    SpscQueueFree(&OutboundQueue);
+    SpscQueueFree(&InputQueue);
 }
 
 // process one frame of updates
@@ -256,21 +1237,45 @@ void Update(double now, float deltaT)
     // we do this so that we don't spam the server with updates 60 times a second and waste bandwidth
     // in a real game we'd send our normalized movement vector or input keys along with what the current tick index was
     // this way the server can know how long it's been since the last update and can do interpolation to know were we are between updates.
-    if (LocalPlayerId >= 0 && now - LastInputSend > InputUpdateInterval)
+    if (LocalPlayerId >= 0 && now - LastInputSend > InputUpdateInterval && AuthoritativeMovement)
     {
-        // Pack up a buffer with the data we want to send
-        uint8_t buffer[9] = { 0 }; // 9 bytes for a 1 byte command number and two bytes for each X and Y value
-        buffer[0] = (uint8_t)UpdateInput;   // this tells the server what kind of data to expect in this packet
-        *(int16_t*)(buffer + 1) = (int16_t)Players[LocalPlayerId].Position.x;
-        *(int16_t*)(buffer + 3) = (int16_t)Players[LocalPlayerId].Position.y;
-        *(int16_t*)(buffer + 5) = (int16_t)Players[LocalPlayerId].Direction.x;
-        *(int16_t*)(buffer + 7) = (int16_t)Players[LocalPlayerId].Direction.y;
+        // send the input we are building now, instead of waiting for it to finish
+        FinishInput();
 
-        // copy this data into a packet provided by enet (TODO : add pack functions that write directly to the packet to avoid the copy)
-        ENetPacket* packet = enet_packet_create(buffer,9,ENET_PACKET_FLAG_RELIABLE);
+        // the network thread sends our inputs on its own schedule, just tell it what we have acknowledged
+        if (NetworkThreadActive)
+        {
+            InputMessage message = { LastSnapshotTick, LastAckedInput, NextInput, false, { 0 } };
+            SpscQueuePush(&InputQueue, &message);
+        }
+        else
+        {
+            SendMoveInput(server, InputHistory, NextInput, LastAckedInput, LastSnapshotTick);
+        }
 
-        // send the packet to the server
-        enet_peer_send(server, 0, packet);
+        LastInputSend = now;
+    }
+    else if (LocalPlayerId >= 0 && now - LastInputSend > InputUpdateInterval)
+    {
+        // Pack up a packet with the data we want to send
+        // this is sent unreliable, if it is lost the next one will have newer data anyway
+        // enet drops unreliable packets that arrive after a newer one on the same channel, so the server only ever moves forward
+        PacketWriter writer;
+        if (PacketWriterBegin(&writer, 9, 0)) // 9 bytes for a 1 byte command number, 4 for the packed position and direction and 4 for the last world update tick
+        {
+            WriteByte(&writer, (uint8_t)UpdateInput);   // this tells the server what kind of data to expect in this packet
+            WriteBits(&writer, QuantizePosition(Players[LocalPlayerId].Position.x, FieldSizeWidth - PlayerSize), POSITION_X_BITS);
+            WriteBits(&writer, QuantizePosition(Players[LocalPlayerId].Position.y, FieldSizeHeight - PlayerSize), POSITION_Y_BITS);
+            WriteBits(&writer, EncodeDirection(Players[LocalPlayerId].Direction.x, Players[LocalPlayerId].Direction.y), DIRECTION_BITS);
+
+            // tell the server what world update we have, so it only sends us what changed since then
+            WriteInt(&writer, LastSnapshotTick);
+
+            // send the packet to the server
+            ENetPacket* packet = PacketWriterEnd(&writer);
+            if (packet != NULL)
+                SendToServer(packet, CHANNEL_UNRELIABLE);
+        }
 
         // NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
         // you don't have to destroy them
@@ -279,100 +1284,42 @@ void Update(double now, float deltaT)
         LastInputSend = now;
     }
 
-    // read one event from enet and process it
-    ENetEvent Event = { 0 };
-
-    // Check to see if we even have any events to do. Since this is a a client, we don't set a timeout so that the client can keep going if there are no events
-    if (enet_host_service(client, &Event, 0) > 0)
+    // keep our idea of the server clock up to date
+    if (LocalPlayerId >= 0 && now >= NextTimeRequest)
     {
-        // see what kind of event it is
-        switch (Event.type)
-        {
-        // the server sent us some data, we should process it
-        case ENET_EVENT_TYPE_RECEIVE:
-        {
-            // we know that all valid packets have a size >= 1, so if we get this, something is bad and we ignore it.
-            if (Event.packet->dataLength < 1)
-                break;
+        SendTimeRequest();
+        NextTimeRequest = now + (TimeSampleCount < TIME_SAMPLES ? TIME_SYNC_FAST_INTERVAL : TIME_SYNC_INTERVAL);
+    }
 
-            // keep an offset of what data we have read so far
-            size_t offset = 0;
+    // process everything that the server has sent us, up to our time budget
+    ProcessNetworkEvents();
 
-            // read off the command that the server wants us to do
-            NetworkCommands command = (NetworkCommands)ReadByte(Event.packet, &offset);
+    // draw remote players a little in the past, between two states we got from the server
+    // the delay grows when updates show up unevenly, and moves slowly so players don't jump when it changes
+    double targetDelay = InterpolationDelay + Jitter * 2;
+    double blend = deltaT * 2 < 1 ? deltaT * 2 : 1;
+    CurrentDelay += (targetDelay - CurrentDelay) * blend;
 
-            // if the server has not accepted us yet, we are limited in what packets we can receive
-            if (LocalPlayerId == -1)
-            {
-                if (command == AcceptPlayer)    // this is the only thing we can do in this state, so ignore anything else
-                {
-                    // See who the server says we are
-                    LocalPlayerId = ReadByte(Event.packet, &offset);
-
-                    // Make sure that it makes sense
-                    if (LocalPlayerId < 0 || LocalPlayerId > MAX_PLAYERS)
-                    {
-                        LocalPlayerId = -1;
-                        break;
-                    }
-
-                    // Force the next frame to do an update by pretending it's been a very long time since our last update
-                    LastInputSend = -InputUpdateInterval;
-
-                    // We are active
-                    Players[LocalPlayerId].Active = true;
-
-                    // Set our player at some location on the field.
-                    // optimally we would do a much more robust connection negotiation where we tell the server what our name is, what we look like
-                    // and then the server tells us where we are
-                    // But for this simple test, everyone starts at the same place on the field
-                    Players[LocalPlayerId].Position = (Vector2){ 100, 100 };
-                }
-            }
-            else // we have been accepted, so process play messages from the server
-            {
-                // see what the server wants us to do
-                switch (command)
-                {
-                case AddPlayer:
-                    HandleAddPlayer(Event.packet, &offset);
-                    break;
-
-                case RemovePlayer:
-                    HandleRemovePlayer(Event.packet, &offset);
-                    break;
-
-                case UpdatePlayer:
-                    HandleUpdatePlayer(Event.packet, &offset);
-                    break;
-                }
-            }
-            // tell enet that it can recycle the packet data
-            enet_packet_destroy(Event.packet);
-            break;
-        }
+    RenderTime = LastNow - ClockOffset - CurrentDelay;
+    float renderTime = (float)(RenderTime - RemoteTimeBase);
 
-        // we were disconnected, we have a sad
-        case ENET_EVENT_TYPE_DISCONNECT:
-            server = NULL;
-            LocalPlayerId = -1;
-            break;
-        }
-    }
-
-    // update all the remote players with an interpolated position based on the last known good pos and how long it has been since an update
-    for (int i = 0; i < MAX_PLAYERS; i++)
+    // players only need new states to blend between about once a tick, or every frame while their updates are late
+    for (int i = 0; i < RemotePlayers.Count; i++)
     {
-        if (i == LocalPlayerId || !Players[i].Active)
-            continue;
-        double delta = LastNow - Players[i].UpdateTime;
-        Players[i].ExtrapolatedPosition = Vector2Add(Players[i].Position, Vector2Scale(Players[i].Direction, delta));
+        if (RemoteStoreNeedsSegment(&RemotePlayers, i, renderTime))
+            SelectSegment(RemotePlayers.Id[i], renderTime);
     }
+
+    // then blend everyone at once
+    RemoteStoreUpdate(&RemotePlayers, renderTime, (float)MAX_EXTRAPOLATION, (float)(FieldSizeWidth - PlayerSize), (float)(FieldSizeHeight - PlayerSize));
 }
 
 // force a disconnect by shutting down enet
 void Disconnect()
 {
+    // the network thread has to be done with the host before we can close it
+    StopNetworkThread();
+
     // close our connection to the server
     if (server != NULL)
         enet_peer_disconnect(server, 0);
@@ -386,6 +1333,83 @@ void Disconnect()
 
     // clean up enet
     enet_deinitialize();
+
+    // release the local simulation
+    free(Players);
+    Players = NULL;
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+    {
+        free(Snapshots[i].Players);
+        Snapshots[i].Players = NULL;
+    }
+    PlayerCapacity = 0;
+    RemoteStoreFree(&RemotePlayers);
+    free(DrawItems);
+    DrawItems = NULL;
+    DrawItemCapacity = 0;
+}
+
+// set if the network runs on its own thread, this is used the next time we connect
+void SetNetworkThread(bool enabled)
+{
+    NetworkThreadEnabled = enabled;
+}
+
+// set how long each frame can spend processing network events
+void SetNetworkTimeBudget(int milliseconds)
+{
+    NetworkTimeBudget = milliseconds > 0 ? milliseconds : 0;
+}
+
+// get the server clock in milliseconds
+uint32_t GetServerClock()
+{
+    return enet_time_get() + (uint32_t)(int32_t)ServerClockOffset;
+}
+
+// get what we think the server clock says right now, in seconds
+double GetServerTime()
+{
+    return GetServerClock() / 1000.0;
+}
+
+// get how far the server clock is ahead of ours, in seconds
+double GetServerTimeOffset()
+{
+    return ServerClockOffset / 1000.0;
+}
+
+// get the tick the server is on right now, with how far it is into the next one
+double GetServerTick()
+{
+    if (SyncTick == 0)
+        return 0;
+
+    return SyncTick + (int32_t)(GetServerClock() - SyncTickTime) / (ServerTickInterval * 1000);
+}
+
+// get how long it takes a message to get to the server and back, in seconds
+double GetRoundTripTime()
+{
+    return RoundTripTime / 1000.0;
+}
+
+// set how far in the past remote players are drawn
+void SetInterpolationDelay(double seconds)
+{
+    InterpolationDelay = seconds > 0 ? seconds : 0;
+}
+
+// get how far in the past remote players are being drawn right now
+double GetInterpolationDelay()
+{
+    return CurrentDelay;
+}
+
+// get how many received messages are waiting to be processed
+int GetNetworkBacklog()
+{
+    return NetworkBacklog;
 }
 
 // true if we are connected and have been accepted
@@ -406,6 +1430,25 @@ void UpdateLocalPlayer(Vector2* movementDelta, float deltaT)
     if (LocalPlayerId < 0)
         return;
 
+    // the server moves us, so turn this into an input for it and predict where it will put us
+    if (AuthoritativeMovement)
+    {
+        // a new direction is a new input
+        uint8_t direction = EncodeDirection(movementDelta->x, movementDelta->y);
+        if (direction != CurrentDirection)
+        {
+            FinishInput();
+            CurrentDirection = direction;
+        }
+
+        CurrentInputTime += deltaT;
+        while (CurrentInputTime * 1000 >= MAX_INPUT_DURATION)
+            FinishInput();
+
+        PredictLocalPlayer();
+        return;
+    }
+
     // add the movement to our location
     Players[LocalPlayerId].Position = Vector2Add(Players[LocalPlayerId].Position, Vector2Scale(*movementDelta, deltaT));
 
@@ -430,13 +1473,59 @@ void UpdateLocalPlayer(Vector2* movementDelta, float deltaT)
 bool GetPlayerPos(int id, Vector2* pos)
 {
     // make sure the player is valid and active
-    if (id < 0 || id >= MAX_PLAYERS || !Players[id].Active)
+    if (id < 0 || id >= PlayerCapacity || !Players[id].Active)
         return false;
 
-    // copy the location (real or extrapolated)
+    // copy the location (real or interpolated)
     if (id == LocalPlayerId)
         *pos = Players[id].Position;
     else
-        *pos = Players[id].ExtrapolatedPosition;
+        *pos = (Vector2){ RemotePlayers.RenderX[Players[id].RenderIndex], RemotePlayers.RenderY[Players[id].RenderIndex] };
     return true;
 }
+
+// get how many player ids the local simulation has room for
+int GetPlayerCapacity()
+{
+    return PlayerCapacity;
+}
+
+// get every player inside a rectangle, in one list for the renderer
+// remote players are read straight out of RemotePlayers, so only players that are in the game are looked at
+const PlayerDrawItem* GetVisiblePlayers(float minX, float minY, float maxX, float maxY, int* count)
+{
+    *count = 0;
+    if (LocalPlayerId < 0)
+        return NULL;
+
+    // make sure there is room for everyone
+    if (DrawItemCapacity < RemotePlayers.Count + 1)
+    {
+        int capacity = RemotePlayers.Capacity + 1;
+        PlayerDrawItem* items = (PlayerDrawItem*)realloc(DrawItems, sizeof(PlayerDrawItem) * capacity);
+        if (items == NULL)
+            return NULL;
+
+        DrawItems = items;
+        DrawItemCapacity = capacity;
+    }
+
+    int visible = 0;
+    Vector2 local = Players[LocalPlayerId].Position;
+    if (local.x >= minX && local.x <= maxX && local.y >= minY && local.y <= maxY)
+        DrawItems[visible++] = (PlayerDrawItem){ LocalPlayerId, local, LocalPlayerId % PLAYER_COLOR_COUNT };
+
+    for (int i = 0; i < RemotePlayers.Count; i++)
+    {
+        float x = RemotePlayers.RenderX[i];
+        float y = RemotePlayers.RenderY[i];
+        if (x < minX || x > maxX || y < minY || y > maxY)
+            continue;
+
+        int id = RemotePlayers.Id[i];
+        DrawItems[visible++] = (PlayerDrawItem){ id, (Vector2){ x, y }, id % PLAYER_COLOR_COUNT };
+    }
+
+    *count = visible;
+    return DrawItems;
+}
@@ -37,12 +37,66 @@
 // It is ok to include raymath, since raymath doesn't have any conflict with windows.h
 #include "raymath.h"
 
+// the constants shared with the server, such as the field size and the most players there can be
+// this does not include enet, so it is safe to use along side raylib
+#include "protocol.h"
+
+// how far in the past (in seconds) remote players are drawn by default, this is two ticks at the default server tick rate
+#define DEFAULT_INTERPOLATION_DELAY 0.1
+
+// how long (in milliseconds) each frame can spend processing network events by default
+#define DEFAULT_NETWORK_TIME_BUDGET 4
+
+// how many different player colors there are, players past this reuse the colors
+#define PLAYER_COLOR_COUNT 8
+
+// one player to draw
+typedef struct
+{
+    int Id;
+    Vector2 Position;
+    int ColorIndex;         // from 0 to PLAYER_COLOR_COUNT - 1
+}PlayerDrawItem;
+
 // Connect to the server (localhost by default)
 void Connect();
 
 // Process one frame of updates
+// this handles every network event that is waiting, unless it runs out of time
 void Update(double now, float deltaT);
 
+// set if the network is serviced by its own thread instead of in Update, this is used the next time Connect is called
+// the thread sends our inputs and acknowledges packets on its own schedule, so a slow frame does not hold up the network
+// Update still handles everything the server sent, so all the game data is only used by the thread that calls Update
+void SetNetworkThread(bool enabled);
+
+// set how long (in milliseconds) each frame can spend processing network events, 0 means no limit
+void SetNetworkTimeBudget(int milliseconds);
+
+// get what the server clock says right now, in seconds
+// the client asks the server what time it is every so often, and works out the difference between the clocks
+double GetServerTime();
+
+// get how far the server clock is ahead of the local network clock, in seconds
+double GetServerTimeOffset();
+
+// get the server tick right now, the fraction is how far into the next tick the server is
+double GetServerTick();
+
+// get how long it takes a message to get to the server and back, in seconds
+double GetRoundTripTime();
+
+// set how far in the past (in seconds) remote players are drawn, so they can be moved smoothly between updates from the server
+// the measured network jitter is added to this
+void SetInterpolationDelay(double seconds);
+
+// get how far in the past remote players are being drawn right now, including the jitter
+double GetInterpolationDelay();
+
+// get how many received messages were left waiting at the end of the last update because we ran out of time
+// this should be 0, if it keeps growing the client can't keep up with the server
+int GetNetworkBacklog();
+
 // Disconnect from the server
 void Disconnect();
 
@@ -59,11 +113,12 @@ int GetLocalPlayerId();
 // returns false if the player id is not valid
 bool GetPlayerPos(int id, Vector2* pos);
 
-// constants
-#define MAX_PLAYERS 8
-// how big the screen is for all players
-#define FieldSizeWidth 1280
-#define FieldSizeHeight  800
+// get how many player ids the local simulation has room for, all valid player ids are less than this
+// this grows as the server tells us about more players
+int GetPlayerCapacity();
 
-// how big a player is
-#define PlayerSize 10
\ No newline at end of file
+// get every player whose position is inside a rectangle, including the local player, all in one list
+// players are drawn PlayerSize to the right and down from their position, so pass a rectangle that is that much bigger to the left and up
+// the list belongs to the network game play and is good until the next call to Update
+// returns the list and sets count to how many players are in it
+const PlayerDrawItem* GetVisiblePlayers(float minX, float minY, float maxX, float maxY, int* count);
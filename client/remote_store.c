@@ -0,0 +1,182 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the remote player storage
+// the update loop is kept free of branches and function calls, so the compiler can vectorize it
+
+#include "remote_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// older versions of visual studio only know restrict by its own name
+#if defined(_MSC_VER)
+#define restrict __restrict
+#endif
+
+// grow one array of the store, keeping what is in it
+static bool GrowArray(void** array, size_t itemSize, int capacity)
+{
+    void* grown = realloc(*array, itemSize * capacity);
+    if (grown == NULL)
+        return false;
+
+    *array = grown;
+    return true;
+}
+
+// make sure the store has room for one more item
+static bool ReserveItem(RemoteStore* store)
+{
+    if (store->Count < store->Capacity)
+        return true;
+
+    // grow by double so that we don't do this for every new player
+    int capacity = store->Capacity < 64 ? 64 : store->Capacity * 2;
+
+    // if one of these fails, the ones before it are just bigger than they need to be, which is fine
+    if (!GrowArray((void**)&store->Id, sizeof(int), capacity)
+        || !GrowArray((void**)&store->FromX, sizeof(float), capacity)
+        || !GrowArray((void**)&store->FromY, sizeof(float), capacity)
+        || !GrowArray((void**)&store->FromTime, sizeof(float), capacity)
+        || !GrowArray((void**)&store->ToX, sizeof(float), capacity)
+        || !GrowArray((void**)&store->ToY, sizeof(float), capacity)
+        || !GrowArray((void**)&store->ToTime, sizeof(float), capacity)
+        || !GrowArray((void**)&store->InvSpan, sizeof(float), capacity)
+        || !GrowArray((void**)&store->DirX, sizeof(float), capacity)
+        || !GrowArray((void**)&store->DirY, sizeof(float), capacity)
+        || !GrowArray((void**)&store->RenderX, sizeof(float), capacity)
+        || !GrowArray((void**)&store->RenderY, sizeof(float), capacity))
+        return false;
+
+    store->Capacity = capacity;
+    return true;
+}
+
+void RemoteStoreFree(RemoteStore* store)
+{
+    free(store->Id);
+    free(store->FromX);
+    free(store->FromY);
+    free(store->FromTime);
+    free(store->ToX);
+    free(store->ToY);
+    free(store->ToTime);
+    free(store->InvSpan);
+    free(store->DirX);
+    free(store->DirY);
+    free(store->RenderX);
+    free(store->RenderY);
+    memset(store, 0, sizeof(RemoteStore));
+}
+
+int RemoteStoreAdd(RemoteStore* store, int id)
+{
+    if (!ReserveItem(store))
+        return -1;
+
+    int index = store->Count++;
+    store->Id[index] = id;
+    RemoteStoreSetSegment(store, index, 0, 0, 0, 0, 0, 0, 0, 0);
+    store->RenderX[index] = 0;
+    store->RenderY[index] = 0;
+    return index;
+}
+
+int RemoteStoreRemove(RemoteStore* store, int index)
+{
+    int last = --store->Count;
+    if (index == last)
+        return -1;
+
+    store->Id[index] = store->Id[last];
+    store->FromX[index] = store->FromX[last];
+    store->FromY[index] = store->FromY[last];
+    store->FromTime[index] = store->FromTime[last];
+    store->ToX[index] = store->ToX[last];
+    store->ToY[index] = store->ToY[last];
+    store->ToTime[index] = store->ToTime[last];
+    store->InvSpan[index] = store->InvSpan[last];
+    store->DirX[index] = store->DirX[last];
+    store->DirY[index] = store->DirY[last];
+    store->RenderX[index] = store->RenderX[last];
+    store->RenderY[index] = store->RenderY[last];
+    return store->Id[index];
+}
+
+void RemoteStoreSetSegment(RemoteStore* store, int index, float fromTime, float fromX, float fromY, float toTime, float toX, float toY, float dirX, float dirY)
+{
+    store->FromX[index] = fromX;
+    store->FromY[index] = fromY;
+    store->FromTime[index] = fromTime;
+    store->ToX[index] = toX;
+    store->ToY[index] = toY;
+    store->ToTime[index] = toTime;
+    store->InvSpan[index] = toTime > fromTime ? 1.0f / (toTime - fromTime) : 0.0f;
+    store->DirX[index] = dirX;
+    store->DirY[index] = dirY;
+}
+
+// blend every item along its segment, the arrays are passed in as restrict so the compiler knows they don't overlap and can use SIMD
+static void InterpolateItems(int count, float time, float maxExtrapolation, float maxX, float maxY,
+    const float* restrict fromX, const float* restrict fromY, const float* restrict fromTime,
+    const float* restrict toX, const float* restrict toY, const float* restrict toTime, const float* restrict invSpan,
+    const float* restrict dirX, const float* restrict dirY, float* restrict renderX, float* restrict renderY)
+{
+    for (int i = 0; i < count; i++)
+    {
+        // how far along the segment we are, a segment with one state is always at its start
+        float t = (time - fromTime[i]) * invSpan[i];
+        t = t < 0 ? 0 : t;
+        t = t > 1 ? 1 : t;
+
+        // how long we have been past the end of the segment, this is 0 until we run out of states
+        float extra = time - toTime[i];
+        extra = extra < 0 ? 0 : extra;
+        extra = extra > maxExtrapolation ? maxExtrapolation : extra;
+
+        float x = fromX[i] + (toX[i] - fromX[i]) * t + dirX[i] * extra;
+        float y = fromY[i] + (toY[i] - fromY[i]) * t + dirY[i] * extra;
+
+        x = x < 0 ? 0 : x;
+        x = x > maxX ? maxX : x;
+        y = y < 0 ? 0 : y;
+        y = y > maxY ? maxY : y;
+
+        renderX[i] = x;
+        renderY[i] = y;
+    }
+}
+
+void RemoteStoreUpdate(RemoteStore* store, float time, float maxExtrapolation, float maxX, float maxY)
+{
+    InterpolateItems(store->Count, time, maxExtrapolation, maxX, maxY,
+        store->FromX, store->FromY, store->FromTime,
+        store->ToX, store->ToY, store->ToTime, store->InvSpan,
+        store->DirX, store->DirY, store->RenderX, store->RenderY);
+}
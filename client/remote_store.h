@@ -0,0 +1,91 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Remote player storage for the client
+// Everything needed to work out where to draw remote players each frame is kept as separate arrays (structure of arrays),
+// packed so the first Count items are the players that are in the game. Players that are not in the game are never looked at.
+// Each item holds the two states the player is being drawn between (a segment), so the per frame pass is one simple loop
+// with no branches or lookups that the compiler turns into SIMD code. Picking a new segment only happens about once a tick.
+#pragma once
+
+#include <stdbool.h>
+
+// the remote players we are drawing
+typedef struct
+{
+    // how many items are in use, and how many there is room for
+    int Count;
+    int Capacity;
+
+    // the player id of each item
+    int* Id;
+
+    // the state each player is being drawn from, and the one they are moving toward
+    // times are in seconds from a base time picked by the caller, so they fit in a float
+    float* FromX;
+    float* FromY;
+    float* FromTime;
+    float* ToX;
+    float* ToY;
+    float* ToTime;
+
+    // 1 / (ToTime - FromTime), or 0 if they are the same state
+    float* InvSpan;
+
+    // the direction they are going at the To state, used to keep them moving for a little while when updates are late
+    float* DirX;
+    float* DirY;
+
+    // where to draw each player, worked out by RemoteStoreUpdate
+    float* RenderX;
+    float* RenderY;
+}RemoteStore;
+
+// release the memory used by a store
+void RemoteStoreFree(RemoteStore* store);
+
+// add a player to the end of the store, the segment starts out empty
+// returns the index of the new item, or -1 if memory could not be allocated
+int RemoteStoreAdd(RemoteStore* store, int id);
+
+// remove an item by moving the last item into its place
+// returns the id of the player that was moved into the index, or -1 if it was the last item
+int RemoteStoreRemove(RemoteStore* store, int index);
+
+// set the two states an item is drawn between, from and to can be the same state
+void RemoteStoreSetSegment(RemoteStore* store, int index, float fromTime, float fromX, float fromY, float toTime, float toX, float toY, float dirX, float dirY);
+
+// true if an item needs a new segment to be drawn at a time
+static inline bool RemoteStoreNeedsSegment(const RemoteStore* store, int index, float time)
+{
+    return time < store->FromTime[index] || time > store->ToTime[index];
+}
+
+// work out where to draw every item at a time, blending along their segment
+// past the end of a segment they keep going the way they were for up to maxExtrapolation seconds, and they are kept inside the field
+void RemoteStoreUpdate(RemoteStore* store, float time, float maxExtrapolation, float maxX, float maxY);
@@ -0,0 +1,89 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the packet reading and writing functions
+
+// ensure we are using winsock2 on windows.
+#if (_WIN32_WINNT < 0x0601)
+	#undef _WIN32_WINNT
+    #define _WIN32_WINNT 0x0601
+#endif
+
+#include "packet_io.h"
+
+bool PacketWriterBegin(PacketWriter* writer, size_t capacity, enet_uint32 flags)
+{
+    writer->Offset = 0;
+    writer->Overflow = false;
+    writer->Bits = 0;
+    writer->BitCount = 0;
+
+    // passing NULL data has enet allocate the packet without copying anything into it
+    writer->Packet = enet_packet_create(NULL, capacity, flags);
+    return writer->Packet != NULL;
+}
+
+ENetPacket* PacketWriterEnd(PacketWriter* writer)
+{
+    if (writer->Packet == NULL)
+        return NULL;
+
+    // write out any bits that are waiting for the rest of their byte
+    PacketWriterAlign(writer);
+
+    ENetPacket* packet = writer->Packet;
+    writer->Packet = NULL;
+
+    if (writer->Overflow)
+    {
+        enet_packet_destroy(packet);
+        return NULL;
+    }
+
+    // the packet was allocated for the most data we could write, so only send what we did write
+    packet->dataLength = writer->Offset;
+    return packet;
+}
+
+void PacketWriterDiscard(PacketWriter* writer)
+{
+    if (writer->Packet != NULL)
+        enet_packet_destroy(writer->Packet);
+
+    writer->Packet = NULL;
+}
+
+void PacketReaderInit(PacketReader* reader, const ENetPacket* packet)
+{
+    reader->Data = packet->data;
+    reader->Length = packet->dataLength;
+    reader->Offset = 0;
+    reader->Overflow = false;
+    reader->Bits = 0;
+    reader->BitCount = 0;
+}
@@ -0,0 +1,310 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Utility functions to read and write data in network packets, shared by the client and the server
+// Writes go directly into an enet packet that is allocated once, so there is no copy from a temporary buffer.
+// All values are stored in network byte order (big endian), so computers with different byte orders can talk to each other.
+// Reads and writes are bounds checked. If one goes past the end of the packet, the overflow flag is set and nothing is read or written.
+// Values can also be written as a number of bits, for data that does not need a whole byte.
+// Bits are packed most significant bit first. Any byte sized read or write starts on the next whole byte.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "enet.h"
+
+// writes data into an enet packet
+typedef struct
+{
+    // the packet being written to, this has room for the capacity passed to PacketWriterBegin
+    ENetPacket* Packet;
+
+    // where the next write will go
+    size_t Offset;
+
+    // true if something did not fit in the packet
+    bool Overflow;
+
+    // bits that have been written but don't make up a whole byte yet
+    uint64_t Bits;
+    int BitCount;
+}PacketWriter;
+
+// reads data out of an enet packet
+typedef struct
+{
+    const uint8_t* Data;
+    size_t Length;
+
+    // where the next read will come from
+    size_t Offset;
+
+    // true if something was read past the end of the packet
+    bool Overflow;
+
+    // bits that have been read from the packet but not used yet
+    uint64_t Bits;
+    int BitCount;
+}PacketReader;
+
+/// <summary>
+/// Start writing a new packet
+/// </summary>
+/// <param name="writer">The writer to setup</param>
+/// <param name="capacity">The most bytes that will be written to the packet</param>
+/// <param name="flags">The enet packet flags to send the packet with</param>
+/// <returns>False if the packet could not be allocated</returns>
+bool PacketWriterBegin(PacketWriter* writer, size_t capacity, enet_uint32 flags);
+
+/// <summary>
+/// Finish writing a packet, trimming it to the data that was written
+/// </summary>
+/// <param name="writer">The writer to finish</param>
+/// <returns>The packet ready to send, or NULL if something did not fit (the packet is destroyed)</returns>
+ENetPacket* PacketWriterEnd(PacketWriter* writer);
+
+/// <summary>
+/// Throw away a packet that was being written and will not be sent
+/// </summary>
+/// <param name="writer">The writer to discard</param>
+void PacketWriterDiscard(PacketWriter* writer);
+
+/// <summary>
+/// Setup a reader to read from the start of a packet
+/// </summary>
+/// <param name="reader">The reader to setup</param>
+/// <param name="packet">The packet to read from</param>
+void PacketReaderInit(PacketReader* reader, const ENetPacket* packet);
+
+// write one byte of packed bits into the packet
+static inline void PacketWriterPutByte(PacketWriter* writer, uint8_t value)
+{
+    if (writer->Overflow || writer->Offset + 1 > writer->Packet->dataLength)
+    {
+        writer->Overflow = true;
+        return;
+    }
+
+    writer->Packet->data[writer->Offset++] = value;
+}
+
+// write out any bits that don't fill a whole byte yet, padding the rest of the byte with zeros
+static inline void PacketWriterAlign(PacketWriter* writer)
+{
+    if (writer->BitCount == 0)
+        return;
+
+    PacketWriterPutByte(writer, (uint8_t)(writer->Bits << (8 - writer->BitCount)));
+    writer->Bits = 0;
+    writer->BitCount = 0;
+}
+
+// write the low bits of a value, up to 32 bits
+static inline void WriteBits(PacketWriter* writer, uint32_t value, int bits)
+{
+    writer->Bits = (writer->Bits << bits) | (value & (uint32_t)((1ull << bits) - 1));
+    writer->BitCount += bits;
+
+    while (writer->BitCount >= 8)
+    {
+        writer->BitCount -= 8;
+        PacketWriterPutByte(writer, (uint8_t)(writer->Bits >> writer->BitCount));
+    }
+}
+
+// write a value that is usually small using as few bits as we can
+// 2 bits say how big it is (4, 8, 12 or 16 bits) followed by the value, so ids under 16 take 6 bits and any 16 bit value fits
+static inline void WriteVarBits(PacketWriter* writer, uint16_t value)
+{
+    int size = 0;
+    while (size < 3 && (value >> ((size + 1) * 4)) != 0)
+        size++;
+
+    WriteBits(writer, (uint32_t)size, 2);
+    WriteBits(writer, value, (size + 1) * 4);
+}
+
+// get a place in the packet to write some bytes to, NULL if they won't fit
+static inline uint8_t* PacketWriterReserve(PacketWriter* writer, size_t size)
+{
+    PacketWriterAlign(writer);
+
+    if (writer->Overflow || writer->Offset + size > writer->Packet->dataLength)
+    {
+        writer->Overflow = true;
+        return NULL;
+    }
+
+    uint8_t* data = writer->Packet->data + writer->Offset;
+    writer->Offset += size;
+    return data;
+}
+
+// write one byte
+static inline void WriteByte(PacketWriter* writer, uint8_t value)
+{
+    uint8_t* data = PacketWriterReserve(writer, 1);
+    if (data != NULL)
+        data[0] = value;
+}
+
+// write an unsigned short
+static inline void WriteUShort(PacketWriter* writer, uint16_t value)
+{
+    uint8_t* data = PacketWriterReserve(writer, 2);
+    if (data == NULL)
+        return;
+
+    data[0] = (uint8_t)(value >> 8);
+    data[1] = (uint8_t)value;
+}
+
+// write a signed short
+static inline void WriteShort(PacketWriter* writer, int16_t value)
+{
+    WriteUShort(writer, (uint16_t)value);
+}
+
+// write an unsigned 32 bit int
+static inline void WriteInt(PacketWriter* writer, uint32_t value)
+{
+    uint8_t* data = PacketWriterReserve(writer, 4);
+    if (data == NULL)
+        return;
+
+    data[0] = (uint8_t)(value >> 24);
+    data[1] = (uint8_t)(value >> 16);
+    data[2] = (uint8_t)(value >> 8);
+    data[3] = (uint8_t)value;
+}
+
+// change a byte that was already written, used for flags that are not known until the end
+static inline void WriteByteAt(PacketWriter* writer, size_t offset, uint8_t value)
+{
+    if (writer->Overflow || offset + 1 > writer->Offset)
+        return;
+
+    writer->Packet->data[offset] = value;
+}
+
+// change an unsigned short that was already written, used for counts that are not known until the end
+static inline void WriteUShortAt(PacketWriter* writer, size_t offset, uint16_t value)
+{
+    if (writer->Overflow || offset + 2 > writer->Offset)
+        return;
+
+    writer->Packet->data[offset] = (uint8_t)(value >> 8);
+    writer->Packet->data[offset + 1] = (uint8_t)value;
+}
+
+// read the low bits of a value, up to 32 bits, 0 if there are not enough left
+static inline uint32_t ReadBits(PacketReader* reader, int bits)
+{
+    while (reader->BitCount < bits)
+    {
+        if (reader->Overflow || reader->Offset + 1 > reader->Length)
+        {
+            reader->Overflow = true;
+            return 0;
+        }
+
+        reader->Bits = (reader->Bits << 8) | reader->Data[reader->Offset++];
+        reader->BitCount += 8;
+    }
+
+    reader->BitCount -= bits;
+    return (uint32_t)(reader->Bits >> reader->BitCount) & (uint32_t)((1ull << bits) - 1);
+}
+
+// read a value written with WriteVarBits
+static inline uint16_t ReadVarBits(PacketReader* reader)
+{
+    int size = (int)ReadBits(reader, 2);
+    return (uint16_t)ReadBits(reader, (size + 1) * 4);
+}
+
+// get where some bytes are to be read from, NULL if they are past the end of the packet
+static inline const uint8_t* PacketReaderTake(PacketReader* reader, size_t size)
+{
+    // byte sized reads start on a whole byte, so throw away any bits left over from the last one
+    reader->Bits = 0;
+    reader->BitCount = 0;
+
+    if (reader->Overflow || reader->Offset + size > reader->Length)
+    {
+        reader->Overflow = true;
+        return NULL;
+    }
+
+    const uint8_t* data = reader->Data + reader->Offset;
+    reader->Offset += size;
+    return data;
+}
+
+// skip over the rest of the packet, used when a message can't be read to the end
+static inline void PacketReaderSkip(PacketReader* reader)
+{
+    reader->Bits = 0;
+    reader->BitCount = 0;
+    reader->Offset = reader->Length;
+}
+
+// read one byte, 0 if there is nothing left
+static inline uint8_t ReadByte(PacketReader* reader)
+{
+    const uint8_t* data = PacketReaderTake(reader, 1);
+    return data != NULL ? data[0] : 0;
+}
+
+// read an unsigned short, 0 if there is not enough left
+static inline uint16_t ReadUShort(PacketReader* reader)
+{
+    const uint8_t* data = PacketReaderTake(reader, 2);
+    if (data == NULL)
+        return 0;
+
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+// read a signed short, 0 if there is not enough left
+static inline int16_t ReadShort(PacketReader* reader)
+{
+    return (int16_t)ReadUShort(reader);
+}
+
+// read an unsigned 32 bit int, 0 if there is not enough left
+static inline uint32_t ReadInt(PacketReader* reader)
+{
+    const uint8_t* data = PacketReaderTake(reader, 4);
+    if (data == NULL)
+        return 0;
+
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
@@ -0,0 +1,193 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Network protocol definitions shared by the client and the server
+// Anything in here must be the same on both sides, so it lives in one place
+// This file must not include enet or raylib, so that it can be used from either side of the networking.h split
+#pragma once
+
+#include <stdint.h>
+
+// how big the screen is for all players
+#define FieldSizeWidth 1280
+#define FieldSizeHeight  800
+
+// how big a player is
+#define PlayerSize 10
+
+// how fast in pixels per second a player moves
+// players move in 8 directions at this speed, so movement can be sent as just the direction
+#define PlayerMoveSpeed 200
+
+// how many bits are used to send a position on each axis, and a direction
+// positions are always inside the field, so they only need enough bits to cover the field size
+#define POSITION_X_BITS     11
+#define POSITION_Y_BITS     10
+#define DIRECTION_BITS      4
+
+// this will fail to compile if the field gets too big for the bits we send positions with
+typedef char PositionBitsCheck[((1 << POSITION_X_BITS) >= FieldSizeWidth && (1 << POSITION_Y_BITS) >= FieldSizeHeight) ? 1 : -1];
+
+// the most players a server can have, player ids are always less than this
+// this is the most peers an enet host can have (ENET_PROTOCOL_MAXIMUM_PEER_ID)
+#define MAX_PLAYERS 4095
+
+// the port the server listens on
+#define SERVER_PORT 4545
+
+// the channels we send data on
+// events that must arrive and be in order (accept, add, remove) go on the reliable channel
+// movement data goes on the unreliable channel, a lost update is replaced by the next one so it's never worth waiting for it to be resent
+#define CHANNEL_RELIABLE    0
+#define CHANNEL_UNRELIABLE  1
+#define CHANNEL_COUNT       2
+
+// how many past world updates are remembered to build delta updates from
+// a client that has not acknowledged a world update in this many ticks gets a full update
+#define SNAPSHOT_HISTORY 64
+
+// bits used in a world update to say what fields of a player are in the message
+#define FIELD_X     0x01
+#define FIELD_Y     0x02
+#define FIELD_DIR   0x04
+#define FIELD_ALL   0x07
+#define FIELD_BITS  3
+
+// world updates that don't fit in one datagram are split into parts, each with the part number in it
+// the high bit of the part number is set on the last part, so the client knows when it has them all
+#define MAX_UPDATE_PARTS    32
+#define UPDATE_PART_LAST    0x80
+
+// how many of its own inputs a client remembers until the server says it has processed them
+// every input message has all of them in it, so a lost message is covered by the next one
+#define INPUT_HISTORY 64
+
+// the longest an input can last (in milliseconds), so it fits in one byte
+#define MAX_INPUT_DURATION 250
+
+// flags sent when a player is accepted, telling the client how the server runs the game
+#define ACCEPT_AUTHORITATIVE 0x01   // the server moves players from their inputs, and the client predicts where it will be
+
+// All the different commands that can be sent over the network
+typedef enum
+{
+    // Server -> Client, You have been accepted. Contains the id for the client player to use, the accept flags,
+    // how long a server tick is in milliseconds, the server clock (see TimeResponse) and a packed start position
+    AcceptPlayer = 1,
+
+    // Server -> Client, Add a new player to your simulation, contains the ID of the player, the tick they were added and a packed position
+    AddPlayer = 2,
+
+    // Server -> Client, Remove a player from your simulation, contains the ID of the player to remove and the tick they were removed
+    RemovePlayer = 3,
+
+    // Server -> Client, Update player positions in the simulation, sent once per server tick
+    // contains the tick of this update, how many ticks older the update it is based on is (0 for none) and the number of players in the update.
+    // Players are bit packed, for each player it contains the ID (see WriteVarBits), a mask of the fields that changed since the base update, and those fields.
+    // Players that did not change since the base update are not sent at all.
+    UpdatePlayer = 4,
+
+    // Client -> Server, Provide an updated location for the client's player, contains the packed postion to update
+    // and the tick of the last world update the client received, so the server can send changes from there
+    // this is only used when the server is not authoritative
+    UpdateInput = 5,
+
+    // Client -> Server, The inputs the server has not processed yet, used when the server is authoritative
+    // contains the tick of the last world update the client received, the sequence number of the first input and how many inputs there are
+    // each input is bit packed as a direction and how long it lasted in milliseconds (8 bits)
+    MoveInput = 6,
+
+    // Server -> Client, Where the server has the client's player after the last input it processed
+    // contains the tick, the sequence number of that input and a packed position, the client replays any newer inputs from there
+    // this is sent in the same packet as the world update, just before it
+    CorrectPlayer = 7,
+
+    // Client -> Server, Ask the server what time it is, contains the client's clock in milliseconds
+    TimeRequest = 8,
+
+    // Server -> Client, The answer to a time request, sent as soon as the request shows up
+    // contains the client's clock from the request, the server clock in milliseconds, the current tick and the server clock when that tick ran
+    TimeResponse = 9,
+}NetworkCommands;
+
+// keep a position inside the field, so it fits in the bits it is sent with
+static inline uint16_t QuantizePosition(float value, int limit)
+{
+    if (value < 0)
+        return 0;
+
+    if (value > limit)
+        return (uint16_t)limit;
+
+    return (uint16_t)(value + 0.5f);
+}
+
+// turn a movement vector into a direction code
+// each axis uses 2 bits, 0 for not moving, 1 for positive and 2 for negative
+static inline uint8_t EncodeDirection(float dx, float dy)
+{
+    uint8_t code = 0;
+
+    if (dx > 0)
+        code |= 1;
+    else if (dx < 0)
+        code |= 2;
+
+    if (dy > 0)
+        code |= 1 << 2;
+    else if (dy < 0)
+        code |= 2 << 2;
+
+    return code;
+}
+
+// turn a direction code back into a movement vector at the player move speed
+static inline void DecodeDirection(uint8_t code, int16_t* dx, int16_t* dy)
+{
+    static const int16_t axis[4] = { 0, PlayerMoveSpeed, -PlayerMoveSpeed, 0 };
+
+    *dx = axis[code & 3];
+    *dy = axis[(code >> 2) & 3];
+}
+
+// move a player along one axis for an input, in whole pixels, keeping it inside the field
+// the client and the server both use this, so the client can predict exactly where the server will put it
+static inline int16_t MoveAxis(int16_t position, int16_t speed, int durationMs, int limit)
+{
+    // round to the nearest pixel, C division rounds toward zero so push it half a pixel away first
+    int distance = speed * durationMs;
+    int value = position + (distance + (distance < 0 ? -500 : 500)) / 1000;
+
+    if (value < 0)
+        value = 0;
+
+    if (value > limit)
+        value = limit;
+
+    return (int16_t)value;
+}
@@ -0,0 +1,94 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the single producer single consumer queue
+// the positions only ever count up and wrap around at 2^32, the capacity is a power of two so they can be masked to find the slot
+
+#include "spsc_queue.h"
+
+// the atomic loads and stores
+#include "threading.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool SpscQueueInit(SpscQueue* queue, uint32_t capacity, uint32_t itemSize)
+{
+    memset(queue, 0, sizeof(SpscQueue));
+
+    uint32_t size = 1;
+    while (size < capacity)
+        size *= 2;
+
+    queue->Items = (uint8_t*)malloc((size_t)size * itemSize);
+    if (queue->Items == NULL)
+        return false;
+
+    queue->Capacity = size;
+    queue->ItemSize = itemSize;
+    return true;
+}
+
+void SpscQueueFree(SpscQueue* queue)
+{
+    free(queue->Items);
+    memset(queue, 0, sizeof(SpscQueue));
+}
+
+bool SpscQueuePush(SpscQueue* queue, const void* item)
+{
+    // only we change the tail, so it does not need to be loaded atomically
+    uint32_t tail = queue->Tail;
+    if (tail - AtomicLoad(&queue->Head) == queue->Capacity)
+        return false;
+
+    memcpy(queue->Items + (size_t)(tail & (queue->Capacity - 1)) * queue->ItemSize, item, queue->ItemSize);
+
+    // the item is written before the consumer can see the new tail
+    AtomicStore(&queue->Tail, tail + 1);
+    return true;
+}
+
+bool SpscQueuePop(SpscQueue* queue, void* item)
+{
+    // only we change the head, so it does not need to be loaded atomically
+    uint32_t head = queue->Head;
+    if (head == AtomicLoad(&queue->Tail))
+        return false;
+
+    memcpy(item, queue->Items + (size_t)(head & (queue->Capacity - 1)) * queue->ItemSize, queue->ItemSize);
+
+    // the item is read out before the producer can reuse the slot
+    AtomicStore(&queue->Head, head + 1);
+    return true;
+}
+
+uint32_t SpscQueueSize(SpscQueue* queue)
+{
+    return AtomicLoad(&queue->Tail) - AtomicLoad(&queue->Head);
+}
@@ -0,0 +1,74 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// A fixed size queue for passing items from one thread to another without a lock
+// Exactly one thread may push and exactly one other thread may pop (single producer, single consumer).
+// Items are copied in and out, so they should be small, such as a pointer to a packet and a few values that go with it.
+// The read and write positions are kept on their own cache lines, so the two threads don't slow each other down.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the size of a cache line on the CPUs we run on
+#define CACHE_LINE_SIZE 64
+
+// a queue of items all the same size
+typedef struct
+{
+    // how many items fit, this is a power of two
+    uint32_t Capacity;
+    uint32_t ItemSize;
+    uint8_t* Items;
+
+    // how many items have been popped, only the consumer changes this
+    volatile uint32_t Head;
+    uint8_t HeadPadding[CACHE_LINE_SIZE - sizeof(uint32_t)];
+
+    // how many items have been pushed, only the producer changes this
+    volatile uint32_t Tail;
+    uint8_t TailPadding[CACHE_LINE_SIZE - sizeof(uint32_t)];
+}SpscQueue;
+
+// setup a queue with room for at least capacity items of itemSize bytes
+// returns false if memory could not be allocated
+bool SpscQueueInit(SpscQueue* queue, uint32_t capacity, uint32_t itemSize);
+
+// release the memory used by a queue, neither thread can be using it
+void SpscQueueFree(SpscQueue* queue);
+
+// copy an item onto the end of the queue, only call this from the producer thread
+// returns false if the queue is full
+bool SpscQueuePush(SpscQueue* queue, const void* item);
+
+// copy the item at the front of the queue out and remove it, only call this from the consumer thread
+// returns false if the queue is empty
+bool SpscQueuePop(SpscQueue* queue, void* item);
+
+// how many items are in the queue, by the time this returns the other thread may have changed it
+uint32_t SpscQueueSize(SpscQueue* queue);
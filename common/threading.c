@@ -0,0 +1,179 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the portable threading functions
+
+#include "threading.h"
+
+#if defined(_WIN32)
+
+// ensure we are using winsock2 on windows, the same as enet does, so windows.h does not pull in the old winsock
+#if (_WIN32_WINNT < 0x0601)
+    #undef _WIN32_WINNT
+    #define _WIN32_WINNT 0x0601
+#endif
+#include <winsock2.h>
+#include <windows.h>
+#include <process.h>
+
+// windows wants a different function signature, so this calls the real function
+static unsigned __stdcall ThreadEntry(void* argument)
+{
+    Thread* thread = (Thread*)argument;
+    thread->Function(thread->Argument);
+    return 0;
+}
+
+bool ThreadStart(Thread* thread, ThreadFunction function, void* argument)
+{
+    thread->Function = function;
+    thread->Argument = argument;
+    thread->Handle = (void*)_beginthreadex(NULL, 0, ThreadEntry, thread, 0, NULL);
+    return thread->Handle != NULL;
+}
+
+void ThreadJoin(Thread* thread)
+{
+    WaitForSingleObject((HANDLE)thread->Handle, INFINITE);
+    CloseHandle((HANDLE)thread->Handle);
+    thread->Handle = NULL;
+}
+
+void ThreadSleep(int milliseconds)
+{
+    Sleep(milliseconds);
+}
+
+// windows has semaphores, so this is just one of those
+Semaphore* SemaphoreCreate()
+{
+    return (Semaphore*)CreateSemaphoreA(NULL, 0, 0x7fffffff, NULL);
+}
+
+void SemaphoreFree(Semaphore* semaphore)
+{
+    CloseHandle((HANDLE)semaphore);
+}
+
+void SemaphoreWait(Semaphore* semaphore)
+{
+    WaitForSingleObject((HANDLE)semaphore, INFINITE);
+}
+
+void SemaphorePost(Semaphore* semaphore)
+{
+    ReleaseSemaphore((HANDLE)semaphore, 1, NULL);
+}
+
+#else
+
+#include <stdlib.h>
+#include <time.h>
+
+// not every pthreads platform has unnamed semaphores, so this builds one from a mutex and a condition
+struct Semaphore
+{
+    pthread_mutex_t Mutex;
+    pthread_cond_t Condition;
+    unsigned int Count;
+};
+
+// pthreads wants a different function signature, so this calls the real function
+static void* ThreadEntry(void* argument)
+{
+    Thread* thread = (Thread*)argument;
+    thread->Function(thread->Argument);
+    return NULL;
+}
+
+bool ThreadStart(Thread* thread, ThreadFunction function, void* argument)
+{
+    thread->Function = function;
+    thread->Argument = argument;
+    return pthread_create(&thread->Handle, NULL, ThreadEntry, thread) == 0;
+}
+
+void ThreadJoin(Thread* thread)
+{
+    pthread_join(thread->Handle, NULL);
+}
+
+void ThreadSleep(int milliseconds)
+{
+    struct timespec time = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+    nanosleep(&time, NULL);
+}
+
+Semaphore* SemaphoreCreate()
+{
+    Semaphore* semaphore = (Semaphore*)malloc(sizeof(Semaphore));
+    if (semaphore == NULL)
+        return NULL;
+
+    semaphore->Count = 0;
+    if (pthread_mutex_init(&semaphore->Mutex, NULL) != 0)
+    {
+        free(semaphore);
+        return NULL;
+    }
+
+    if (pthread_cond_init(&semaphore->Condition, NULL) != 0)
+    {
+        pthread_mutex_destroy(&semaphore->Mutex);
+        free(semaphore);
+        return NULL;
+    }
+
+    return semaphore;
+}
+
+void SemaphoreFree(Semaphore* semaphore)
+{
+    pthread_cond_destroy(&semaphore->Condition);
+    pthread_mutex_destroy(&semaphore->Mutex);
+    free(semaphore);
+}
+
+void SemaphoreWait(Semaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->Mutex);
+    while (semaphore->Count == 0)
+        pthread_cond_wait(&semaphore->Condition, &semaphore->Mutex);
+    semaphore->Count--;
+    pthread_mutex_unlock(&semaphore->Mutex);
+}
+
+void SemaphorePost(Semaphore* semaphore)
+{
+    pthread_mutex_lock(&semaphore->Mutex);
+    semaphore->Count++;
+    pthread_cond_signal(&semaphore->Condition);
+    pthread_mutex_unlock(&semaphore->Mutex);
+}
+
+#endif
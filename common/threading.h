@@ -0,0 +1,148 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Small portable threading functions, shared by the client and the server
+// Threads use the Windows API on Windows and pthreads everywhere else.
+// The atomic functions are just what is needed to pass data between threads without a lock,
+// a load that sees everything written before the matching store.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_WIN32)
+#include <intrin.h>
+#else
+#include <pthread.h>
+#endif
+
+// a variable that each thread has its own copy of
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// the function a thread runs
+typedef void (*ThreadFunction)(void* argument);
+
+// a running thread, this must stay in the same place in memory until it is joined
+typedef struct
+{
+    ThreadFunction Function;
+    void* Argument;
+
+#if defined(_WIN32)
+    void* Handle;
+#else
+    pthread_t Handle;
+#endif
+}Thread;
+
+// start a thread running a function
+// returns false if the thread could not be started
+bool ThreadStart(Thread* thread, ThreadFunction function, void* argument);
+
+// wait for a thread to return from its function
+void ThreadJoin(Thread* thread);
+
+// give up the rest of this thread's time for a number of milliseconds
+void ThreadSleep(int milliseconds);
+
+// a counting semaphore, one thread waits for it and another posts to it to wake it up
+// the platform type is hidden so this header does not need windows.h
+typedef struct Semaphore Semaphore;
+
+// make a semaphore with a count of 0
+// returns NULL if it could not be made
+Semaphore* SemaphoreCreate();
+
+// release a semaphore, nothing can be waiting on it
+void SemaphoreFree(Semaphore* semaphore);
+
+// wait until the count is more than 0, and take one from it
+void SemaphoreWait(Semaphore* semaphore);
+
+// add one to the count, waking up a thread that is waiting
+void SemaphorePost(Semaphore* semaphore);
+
+// read a value another thread stores with AtomicStore
+// anything that thread wrote before the store can be read safely after this
+static inline uint32_t AtomicLoad(volatile uint32_t* value)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)_InterlockedOr((volatile long*)value, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// write a value for another thread to read with AtomicLoad
+static inline void AtomicStore(volatile uint32_t* value, uint32_t newValue)
+{
+#if defined(_MSC_VER)
+    _InterlockedExchange((volatile long*)value, (long)newValue);
+#else
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#endif
+}
+
+// the same as AtomicLoad for a 64 bit value, both halves always come from the same store
+static inline uint64_t AtomicLoad64(volatile uint64_t* value)
+{
+#if defined(_MSC_VER)
+    return (uint64_t)_InterlockedCompareExchange64((volatile __int64*)value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+// the same as AtomicStore for a 64 bit value
+static inline void AtomicStore64(volatile uint64_t* value, uint64_t newValue)
+{
+#if defined(_MSC_VER)
+    // 32 bit windows has no 64 bit exchange, so swap it in until nothing else has changed it first
+    __int64 oldValue;
+    do
+    {
+        oldValue = *(volatile __int64*)value;
+    } while (_InterlockedCompareExchange64((volatile __int64*)value, (__int64)newValue, oldValue) != oldValue);
+#else
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#endif
+}
+
+// add to a value that other threads are also adding to, and get what it was before
+static inline uint32_t AtomicAdd(volatile uint32_t* value, uint32_t amount)
+{
+#if defined(_MSC_VER)
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)value, (long)amount);
+#else
+    return __atomic_fetch_add(value, amount, __ATOMIC_ACQ_REL);
+#endif
+}
@@ -162,6 +162,27 @@
     #define MSG_NOSIGNAL 0
     #endif
 
+    /* recvmmsg and sendmmsg are only declared when _GNU_SOURCE is defined before the first system header */
+    #if defined(__linux__) && defined(_GNU_SOURCE) && !defined(ENET_NO_RECVMMSG)
+    #define ENET_USE_RECVMMSG 1
+    #endif
+
+    #if defined(__linux__) && defined(_GNU_SOURCE) && !defined(ENET_NO_SENDMMSG)
+    #define ENET_USE_SENDMMSG 1
+    #endif
+
+    /* io_uring is called directly, it needs headers from a kernel with multishot receives (6.0 or newer) */
+    #if defined(__linux__) && !defined(ENET_NO_IO_URING) && defined(__has_include)
+    #if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #if defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+    #define ENET_USE_IO_URING 1
+    #endif
+    #endif
+    #endif
+
     #ifdef MSG_MAXIOVLEN
     #define ENET_BUFFER_MAXIMUM MSG_MAXIOVLEN
     #endif
@@ -254,6 +275,26 @@ extern "C" {
     extern ENetPacket* enet_packet_copy(ENetPacket*);
     extern void enet_packet_destroy(ENetPacket*);
 
+    /**
+     * Counters kept by the pooled allocators, see enet_pool_get_stats() and enet_host_get_command_pool_stats().
+     */
+    typedef struct _ENetPoolStats {
+        enet_uint64 hits;     /**< allocations served from a free list */
+        enet_uint64 misses;   /**< allocations that had to go to the underlying allocator */
+        enet_uint64 oversize; /**< allocations too big for any size class, always a miss */
+        enet_uint64 cached;   /**< blocks currently sitting on the free lists */
+    } ENetPoolStats;
+
+    /**
+     * Size class pool that can be installed as the malloc/free pair of ENetCallbacks. Blocks up to
+     * ENET_POOL_MAXIMUM_SIZE bytes are kept on per class free lists when freed instead of going back
+     * to malloc, so steady packet traffic stops hitting the system allocator. It is safe to allocate
+     * on one thread and free on another.
+     */
+    extern void * ENET_CALLBACK enet_pool_malloc(size_t);
+    extern void   ENET_CALLBACK enet_pool_free(void *);
+    extern void   enet_pool_get_stats(ENetPoolStats *);
+
 // =======================================================================//
 // !
 // ! List
@@ -492,6 +533,7 @@ extern "C" {
         ENET_SOCKOPT_ERROR     = 8,
         ENET_SOCKOPT_NODELAY   = 9,
         ENET_SOCKOPT_IPV6_V6ONLY = 10,
+        ENET_SOCKOPT_REUSEPORT = 11,
     } ENetSocketOption;
 
     typedef enum _ENetSocketShutdown {
@@ -613,6 +655,8 @@ extern "C" {
         ENET_HOST_DEFAULT_MTU                  = 1400,
         ENET_HOST_DEFAULT_MAXIMUM_PACKET_SIZE  = 32 * 1024 * 1024,
         ENET_HOST_DEFAULT_MAXIMUM_WAITING_DATA = 32 * 1024 * 1024,
+        ENET_HOST_RECEIVE_BATCH                = 32,
+        ENET_HOST_SEND_BATCH                   = 64,
 
         ENET_PEER_DEFAULT_ROUND_TRIP_TIME      = 500,
         ENET_PEER_DEFAULT_PACKET_THROTTLE      = 32,
@@ -792,6 +836,10 @@ extern "C" {
         size_t                duplicatePeers;     /**< optional number of allowed peers from duplicate IPs, defaults to ENET_PROTOCOL_MAXIMUM_PEER_ID */
         size_t                maximumPacketSize;  /**< the maximum allowable packet size that may be sent or received on a peer */
         size_t                maximumWaitingData; /**< the maximum aggregate amount of buffer space a peer may use waiting for packets to be delivered */
+        struct _ENetReceiveBatch * receiveBatch;  /**< datagrams read together with recvmmsg that have not been handled yet, NULL where it is not used */
+        struct _ENetSendBatch *    sendBatch;     /**< datagrams waiting to be sent together with sendmmsg, NULL unless enabled with enet_host_set_send_batching */
+        struct _ENetUring *        uring;         /**< io_uring that does all of the socket's reads and writes, NULL unless enabled with enet_host_set_io_uring */
+        struct _ENetCommandPool *  commandPool;   /**< freed command and acknowledgement nodes kept for reuse, NULL unless enabled with enet_host_set_command_pool */
     } ENetHost;
 
     /**
@@ -992,6 +1040,11 @@ extern "C" {
     ENET_API void       enet_host_compress(ENetHost *, const ENetCompressor *);
     ENET_API void       enet_host_channel_limit(ENetHost *, size_t);
     ENET_API void       enet_host_bandwidth_limit(ENetHost *, enet_uint32, enet_uint32);
+    ENET_API int        enet_host_set_send_batching(ENetHost *, int);
+    ENET_API int        enet_host_set_io_uring(ENetHost *, int);
+    ENET_API ENetSocket enet_host_get_wait_socket(ENetHost *);
+    ENET_API int        enet_host_set_command_pool(ENetHost *, int);
+    ENET_API void       enet_host_get_command_pool_stats(ENetHost *, ENetPoolStats *);
     extern   void       enet_host_bandwidth_throttle(ENetHost *);
     extern  enet_uint64 enet_host_random_seed(void);
 
@@ -1286,6 +1339,206 @@ extern "C" {
         callbacks.free(memory);
     }
 
+// =======================================================================//
+// !
+// ! Pooled allocation
+// !
+// =======================================================================//
+
+    #define ENET_POOL_MINIMUM_SIZE   64
+    #define ENET_POOL_MAXIMUM_SIZE   4096
+    #define ENET_POOL_CLASS_COUNT    7    /* 64, 128, ... 4096 */
+    #define ENET_POOL_CLASS_CAPACITY 1024 /* freed blocks kept per class, the rest go back to free() */
+    #define ENET_POOL_HEADER_SIZE    16   /* keeps the pointer handed out as aligned as malloc's */
+    #define ENET_POOL_OVERSIZE       ((size_t) -1)
+
+    typedef struct _ENetPoolClass {
+        int         lock;
+        void *      freeList;
+        size_t      count;
+        enet_uint64 hits;
+        enet_uint64 misses;
+    } ENetPoolClass;
+
+    static ENetPoolClass enet_pool_classes[ENET_POOL_CLASS_COUNT];
+    static enet_uint64   enet_pool_oversize;
+
+    static void enet_pool_lock(ENetPoolClass *poolClass) {
+        while (ENET_ATOMIC_CAS(&poolClass->lock, 0, 1) != 0) {}
+    }
+
+    static void enet_pool_unlock(ENetPoolClass *poolClass) {
+        ENET_ATOMIC_WRITE(&poolClass->lock, 0);
+    }
+
+    void * ENET_CALLBACK enet_pool_malloc(size_t size) {
+        size_t classIndex = 0, classSize = ENET_POOL_MINIMUM_SIZE;
+        ENetPoolClass *poolClass;
+        enet_uint8 *block;
+
+        if (size > ENET_POOL_MAXIMUM_SIZE - ENET_POOL_HEADER_SIZE) {
+            block = (enet_uint8 *) malloc(size + ENET_POOL_HEADER_SIZE);
+
+            if (block == NULL) {
+                return NULL;
+            }
+
+            ENET_ATOMIC_INC(&enet_pool_oversize);
+            *(size_t *) block = ENET_POOL_OVERSIZE;
+            return block + ENET_POOL_HEADER_SIZE;
+        }
+
+        while (classSize - ENET_POOL_HEADER_SIZE < size) {
+            classSize <<= 1;
+            ++classIndex;
+        }
+
+        poolClass = &enet_pool_classes[classIndex];
+        enet_pool_lock(poolClass);
+
+        block = (enet_uint8 *) poolClass->freeList;
+
+        if (block != NULL) {
+            poolClass->freeList = *(void **) block;
+            --poolClass->count;
+            ++poolClass->hits;
+        } else {
+            ++poolClass->misses;
+        }
+
+        enet_pool_unlock(poolClass);
+
+        if (block == NULL) {
+            block = (enet_uint8 *) malloc(classSize);
+
+            if (block == NULL) {
+                return NULL;
+            }
+        }
+
+        *(size_t *) block = classIndex;
+        return block + ENET_POOL_HEADER_SIZE;
+    }
+
+    void ENET_CALLBACK enet_pool_free(void *memory) {
+        enet_uint8 *block;
+        ENetPoolClass *poolClass;
+        size_t classIndex;
+
+        if (memory == NULL) {
+            return;
+        }
+
+        block      = (enet_uint8 *) memory - ENET_POOL_HEADER_SIZE;
+        classIndex = *(size_t *) block;
+
+        if (classIndex == ENET_POOL_OVERSIZE) {
+            free(block);
+            return;
+        }
+
+        poolClass = &enet_pool_classes[classIndex];
+        enet_pool_lock(poolClass);
+
+        if (poolClass->count < ENET_POOL_CLASS_CAPACITY) {
+            *(void **) block    = poolClass->freeList;
+            poolClass->freeList = block;
+            ++poolClass->count;
+            block = NULL;
+        }
+
+        enet_pool_unlock(poolClass);
+
+        if (block != NULL) {
+            free(block);
+        }
+    }
+
+    /** Adds up the counters of every size class of the shared pool.
+     *  @param stats filled in with the totals
+     */
+    void enet_pool_get_stats(ENetPoolStats *stats) {
+        size_t i;
+
+        memset(stats, 0, sizeof(ENetPoolStats));
+
+        for (i = 0; i < ENET_POOL_CLASS_COUNT; ++i) {
+            ENetPoolClass *poolClass = &enet_pool_classes[i];
+
+            enet_pool_lock(poolClass);
+            stats->hits   += poolClass->hits;
+            stats->misses += poolClass->misses;
+            stats->cached += poolClass->count;
+            enet_pool_unlock(poolClass);
+        }
+
+        stats->oversize = ENET_ATOMIC_READ(&enet_pool_oversize);
+        stats->misses  += stats->oversize;
+    }
+
+    #define ENET_COMMAND_POOL_CAPACITY 4096 /* freed nodes a host keeps, the rest go back to enet_free() */
+
+    /* every command node is allocated big enough to be reused as any of the three kinds */
+    typedef union _ENetCommandNode {
+        ENetOutgoingCommand outgoing;
+        ENetIncomingCommand incoming;
+        ENetAcknowledgement acknowledgement;
+    } ENetCommandNode;
+
+    typedef struct _ENetCommandPool {
+        void *      freeList;
+        size_t      count;
+        enet_uint64 hits;
+        enet_uint64 misses;
+    } ENetCommandPool;
+
+    /* only the thread servicing the host touches its commands, so the host's pool needs no lock */
+    static void * enet_host_command_malloc(ENetHost *host) {
+        ENetCommandPool *pool = host->commandPool;
+        void *node;
+
+        if (pool != NULL) {
+            if (pool->freeList != NULL) {
+                node = pool->freeList;
+                pool->freeList = *(void **) node;
+                --pool->count;
+                ++pool->hits;
+                return node;
+            }
+
+            ++pool->misses;
+        }
+
+        return enet_malloc(sizeof(ENetCommandNode));
+    }
+
+    static void enet_host_command_free(ENetHost *host, void *node) {
+        ENetCommandPool *pool = host->commandPool;
+
+        if (pool != NULL && pool->count < ENET_COMMAND_POOL_CAPACITY) {
+            *(void **) node = pool->freeList;
+            pool->freeList = node;
+            ++pool->count;
+            return;
+        }
+
+        enet_free(node);
+    }
+
+    static void enet_host_command_pool_destroy(ENetCommandPool *pool) {
+        if (pool == NULL) {
+            return;
+        }
+
+        while (pool->freeList != NULL) {
+            void *node = pool->freeList;
+            pool->freeList = *(void **) node;
+            enet_free(node);
+        }
+
+        enet_free(pool);
+    }
+
 // =======================================================================//
 // !
 // ! List
@@ -1671,7 +1924,7 @@ extern "C" {
                 }
             }
 
-            enet_free(outgoingCommand);
+            enet_host_command_free(peer->host, outgoingCommand);
         }
     }
 
@@ -1743,7 +1996,7 @@ extern "C" {
             }
         }
 
-        enet_free(outgoingCommand);
+        enet_host_command_free(peer->host, outgoingCommand);
 
         if (enet_list_empty(&peer->sentReliableCommands)) {
             return commandNumber;
@@ -2678,6 +2931,562 @@ extern "C" {
         return 0;
     } /* enet_protocol_handle_incoming_commands */
 
+    #ifdef ENET_USE_RECVMMSG
+    /** Datagrams read from the socket with one recvmmsg call. They are handled in order, one per
+     *  call to enet_protocol_receive_batched, and the socket is only read again once they are all used.
+     */
+    typedef struct _ENetReceiveBatch {
+        struct mmsghdr      messages[ENET_HOST_RECEIVE_BATCH];
+        struct iovec        vectors[ENET_HOST_RECEIVE_BATCH];
+        struct sockaddr_in6 addresses[ENET_HOST_RECEIVE_BATCH];
+        int                 count;
+        int                 next;
+        enet_uint8          data[ENET_HOST_RECEIVE_BATCH][ENET_PROTOCOL_MAXIMUM_MTU];
+    } ENetReceiveBatch;
+
+    /** Takes the next datagram from the host's receive batch, reading a new batch if it is empty.
+     *  Returns the same as enet_socket_receive, and points host->receivedData at the datagram.
+     */
+    static int enet_protocol_receive_batched(ENetHost *host) {
+        ENetReceiveBatch *batch = host->receiveBatch;
+        struct mmsghdr *message;
+
+        if (batch->next >= batch->count) {
+            int i, received;
+
+            for (i = 0; i < ENET_HOST_RECEIVE_BATCH; ++i) {
+                batch->vectors[i].iov_base = batch->data[i];
+                batch->vectors[i].iov_len  = host->mtu;
+
+                memset(&batch->messages[i], 0, sizeof(struct mmsghdr));
+                batch->messages[i].msg_hdr.msg_name    = &batch->addresses[i];
+                batch->messages[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+                batch->messages[i].msg_hdr.msg_iov     = &batch->vectors[i];
+                batch->messages[i].msg_hdr.msg_iovlen  = 1;
+            }
+
+            batch->count = 0;
+            batch->next  = 0;
+
+            /* the socket is non-blocking, so this takes whatever is waiting up to a full batch */
+            received = recvmmsg(host->socket, batch->messages, ENET_HOST_RECEIVE_BATCH, MSG_NOSIGNAL, NULL);
+
+            if (received == -1) {
+                if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                    return 0;
+                }
+
+                return -1;
+            }
+
+            batch->count = received;
+        }
+
+        message = &batch->messages[batch->next];
+        host->receivedData = batch->data[batch->next];
+        batch->next++;
+
+        if (message->msg_hdr.msg_flags & MSG_TRUNC) {
+            return -1;
+        }
+
+        host->receivedAddress.host          = batch->addresses[batch->next - 1].sin6_addr;
+        host->receivedAddress.port          = ENET_NET_TO_HOST_16(batch->addresses[batch->next - 1].sin6_port);
+        host->receivedAddress.sin6_scope_id = batch->addresses[batch->next - 1].sin6_scope_id;
+
+        return (int) message->msg_len;
+    } /* enet_protocol_receive_batched */
+    #endif
+
+    #ifdef ENET_USE_IO_URING
+    /* io_uring sizes: the submission queue, the receive buffers the kernel picks from and the send slots */
+    #define ENET_URING_QUEUE_SIZE      256
+    #define ENET_URING_RECEIVE_BUFFERS 256
+    #define ENET_URING_SEND_SLOTS      128
+    #define ENET_URING_BUFFER_SIZE     (sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in6) + ENET_PROTOCOL_MAXIMUM_MTU)
+    #define ENET_URING_BUFFER_GROUP    0
+
+    /* user_data of the receive and of the cancel that stops it, sends use their slot index */
+    #define ENET_URING_RECEIVE_DATA    0xFFFFFFFFFFFFFFFFULL
+    #define ENET_URING_CANCEL_DATA     0xFFFFFFFFFFFFFFFEULL
+
+    /** One datagram waiting for the kernel to send it. It can't be reused until its completion comes back. */
+    typedef struct _ENetUringSend {
+        struct msghdr       message;
+        struct iovec        vector;
+        struct sockaddr_in6 address;
+        enet_uint8          data[ENET_PROTOCOL_MAXIMUM_MTU];
+    } ENetUringSend;
+
+    /** An io_uring for one host's socket.
+     *  A multishot recvmsg stays posted and the kernel fills buffers from a registered buffer ring with each datagram,
+     *  so nothing has to be submitted to receive. Sends are queued as they are made and submitted with one call per flush.
+     */
+    typedef struct _ENetUring {
+        int                        fd;
+        ENetSocket                 socket;
+
+        void *                     sqRing;
+        size_t                     sqRingSize;
+        unsigned *                 sqHead;
+        unsigned *                 sqTail;
+        unsigned *                 sqArray;
+        unsigned                   sqMask;
+        unsigned                   sqEntries;
+        unsigned                   sqLocalTail;
+        struct io_uring_sqe *      sqes;
+        size_t                     sqesSize;
+
+        void *                     cqRing;
+        size_t                     cqRingSize;
+        unsigned *                 cqHead;
+        unsigned *                 cqTail;
+        unsigned                   cqMask;
+        struct io_uring_cqe *      cqes;
+
+        struct io_uring_buf_ring * bufferRing;
+        size_t                     bufferRingSize;
+        enet_uint8 *               buffers;
+        unsigned short             bufferTail;
+
+        /* buffers the kernel has filled that have not been handled yet, and the one being handled now */
+        unsigned short             ready[ENET_URING_RECEIVE_BUFFERS];
+        unsigned                   readyHead;
+        unsigned                   readyTail;
+        int                        heldBuffer;
+
+        struct msghdr              receiveMessage;
+        int                        receiveArmed;
+
+        ENetUringSend *            sends;
+        int                        freeSends[ENET_URING_SEND_SLOTS];
+        int                        freeSendCount;
+    } ENetUring;
+
+    static int enet_uring_setup(unsigned entries, struct io_uring_params *params) {
+        return (int) syscall(__NR_io_uring_setup, entries, params);
+    }
+
+    static int enet_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return (int) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+    }
+
+    static int enet_uring_register(int fd, unsigned opcode, void *argument, unsigned count) {
+        return (int) syscall(__NR_io_uring_register, fd, opcode, argument, count);
+    }
+
+    /** Gives everything queued since the last call to the kernel, and waits for minComplete completions. */
+    static int enet_uring_submit(ENetUring *uring, unsigned minComplete) {
+        unsigned toSubmit;
+        int result;
+
+        __atomic_store_n(uring->sqTail, uring->sqLocalTail, __ATOMIC_RELEASE);
+        toSubmit = uring->sqLocalTail - __atomic_load_n(uring->sqHead, __ATOMIC_ACQUIRE);
+
+        if (toSubmit == 0 && minComplete == 0) {
+            return 0;
+        }
+
+        do {
+            result = enet_uring_enter(uring->fd, toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0);
+        } while (result < 0 && errno == EINTR);
+
+        return result < 0 ? -1 : 0;
+    }
+
+    /** The next free submission entry, cleared, or NULL if the queue is full even after submitting. */
+    static struct io_uring_sqe * enet_uring_get_sqe(ENetUring *uring) {
+        struct io_uring_sqe *sqe;
+
+        if (uring->sqLocalTail - __atomic_load_n(uring->sqHead, __ATOMIC_ACQUIRE) >= uring->sqEntries) {
+            if (enet_uring_submit(uring, 0) < 0 || uring->sqLocalTail - __atomic_load_n(uring->sqHead, __ATOMIC_ACQUIRE) >= uring->sqEntries) {
+                return NULL;
+            }
+        }
+
+        sqe = &uring->sqes[uring->sqLocalTail & uring->sqMask];
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        uring->sqArray[uring->sqLocalTail & uring->sqMask] = uring->sqLocalTail & uring->sqMask;
+        uring->sqLocalTail++;
+
+        return sqe;
+    }
+
+    /** Gives a receive buffer back to the kernel to fill again. */
+    static void enet_uring_return_buffer(ENetUring *uring, int bufferId) {
+        struct io_uring_buf *buffer = &uring->bufferRing->bufs[uring->bufferTail & (ENET_URING_RECEIVE_BUFFERS - 1)];
+
+        buffer->addr = (enet_uint64) (uintptr_t) (uring->buffers + (size_t) bufferId * ENET_URING_BUFFER_SIZE);
+        buffer->len  = (enet_uint32) ENET_URING_BUFFER_SIZE;
+        buffer->bid  = (enet_uint16) bufferId;
+
+        uring->bufferTail++;
+        __atomic_store_n(&uring->bufferRing->tail, uring->bufferTail, __ATOMIC_RELEASE);
+    }
+
+    /** Posts the multishot receive. It stays posted until it runs out of buffers or fails. */
+    static int enet_uring_arm_receive(ENetUring *uring) {
+        struct io_uring_sqe *sqe = enet_uring_get_sqe(uring);
+
+        if (sqe == NULL) {
+            return -1;
+        }
+
+        memset(&uring->receiveMessage, 0, sizeof(struct msghdr));
+        uring->receiveMessage.msg_namelen = sizeof(struct sockaddr_in6);
+
+        sqe->opcode    = IORING_OP_RECVMSG;
+        sqe->fd        = uring->socket;
+        sqe->addr      = (enet_uint64) (uintptr_t) &uring->receiveMessage;
+        sqe->len       = 1;
+        sqe->ioprio    = IORING_RECV_MULTISHOT;
+        sqe->flags     = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = ENET_URING_BUFFER_GROUP;
+        sqe->user_data = ENET_URING_RECEIVE_DATA;
+
+        uring->receiveArmed = 1;
+        return 0;
+    }
+
+    /** Handles every completion waiting. Sends give their slot back, received datagrams wait in the ready list.
+     *  Returns -1 if the receive was rejected outright, which means the kernel can't do multishot receives.
+     */
+    static int enet_uring_reap(ENetUring *uring) {
+        unsigned head = *uring->cqHead;
+        unsigned tail = __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE);
+        int result = 0;
+
+        for (; head != tail; ++head) {
+            struct io_uring_cqe *cqe = &uring->cqes[head & uring->cqMask];
+
+            if (cqe->user_data == ENET_URING_RECEIVE_DATA) {
+                if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                    uring->receiveArmed = 0;
+                }
+
+                if (cqe->flags & IORING_CQE_F_BUFFER) {
+                    int bufferId = (int) (cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+
+                    /* a failed receive can still have taken a buffer, give it straight back */
+                    if (cqe->res >= 0) {
+                        uring->ready[uring->readyTail++ & (ENET_URING_RECEIVE_BUFFERS - 1)] = (unsigned short) bufferId;
+                    } else {
+                        enet_uring_return_buffer(uring, bufferId);
+                    }
+                } else if (cqe->res == -EINVAL) {
+                    result = -1;
+                }
+            } else if (cqe->user_data < ENET_URING_SEND_SLOTS) {
+                uring->freeSends[uring->freeSendCount++] = (int) cqe->user_data;
+            }
+        }
+
+        __atomic_store_n(uring->cqHead, head, __ATOMIC_RELEASE);
+        return result;
+    }
+
+    /** Stops the receive and waits for everything the kernel still has to finish, so nothing writes to memory about to be freed. */
+    static void enet_uring_drain(ENetUring *uring) {
+        int tries;
+
+        if (uring->receiveArmed) {
+            struct io_uring_sqe *sqe = enet_uring_get_sqe(uring);
+
+            if (sqe != NULL) {
+                sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+                sqe->addr      = ENET_URING_RECEIVE_DATA;
+                sqe->user_data = ENET_URING_CANCEL_DATA;
+            }
+        }
+
+        for (tries = 0; tries < 100 && (uring->receiveArmed || uring->freeSendCount < ENET_URING_SEND_SLOTS); ++tries) {
+            if (enet_uring_submit(uring, 1) < 0) {
+                break;
+            }
+
+            enet_uring_reap(uring);
+        }
+
+        /* anything that came in is dropped, but the buffers go back so the kernel can use them again */
+        while (uring->readyHead != uring->readyTail) {
+            enet_uring_return_buffer(uring, uring->ready[uring->readyHead++ & (ENET_URING_RECEIVE_BUFFERS - 1)]);
+        }
+
+        if (uring->heldBuffer >= 0) {
+            enet_uring_return_buffer(uring, uring->heldBuffer);
+            uring->heldBuffer = -1;
+        }
+    }
+
+    static void enet_uring_destroy(ENetUring *uring) {
+        if (uring == NULL) {
+            return;
+        }
+
+        if (uring->fd >= 0) {
+            if (uring->sqes != NULL && uring->cqes != NULL) {
+                enet_uring_drain(uring);
+            }
+
+            close(uring->fd);
+        }
+
+        if (uring->sqes != NULL) {
+            munmap(uring->sqes, uring->sqesSize);
+        }
+
+        if (uring->cqRing != NULL && uring->cqRing != uring->sqRing) {
+            munmap(uring->cqRing, uring->cqRingSize);
+        }
+
+        if (uring->sqRing != NULL) {
+            munmap(uring->sqRing, uring->sqRingSize);
+        }
+
+        if (uring->bufferRing != NULL) {
+            munmap(uring->bufferRing, uring->bufferRingSize);
+        }
+
+        enet_free(uring->buffers);
+        enet_free(uring->sends);
+        enet_free(uring);
+    }
+
+    /** Sets up an io_uring for a socket, or returns NULL if the kernel can't do everything it needs. */
+    static ENetUring * enet_uring_create(ENetSocket socket) {
+        struct io_uring_params params;
+        struct io_uring_buf_reg bufferRegister;
+        ENetUring *uring;
+        void *mapping;
+        int i;
+
+        uring = (ENetUring *) enet_malloc(sizeof(ENetUring));
+        if (uring == NULL) {
+            return NULL;
+        }
+
+        memset(uring, 0, sizeof(ENetUring));
+        uring->socket     = socket;
+        uring->heldBuffer = -1;
+
+        memset(&params, 0, sizeof(params));
+        uring->fd = enet_uring_setup(ENET_URING_QUEUE_SIZE, &params);
+        if (uring->fd < 0) {
+            goto fail;
+        }
+
+        /* the completion queue has to have room for a completion from every buffer and send slot at once */
+        if (params.cq_entries < ENET_URING_RECEIVE_BUFFERS + ENET_URING_SEND_SLOTS + 2) {
+            goto fail;
+        }
+
+        uring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        uring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            if (uring->cqRingSize > uring->sqRingSize) {
+                uring->sqRingSize = uring->cqRingSize;
+            }
+
+            uring->cqRingSize = uring->sqRingSize;
+        }
+
+        mapping = mmap(NULL, uring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+        if (mapping == MAP_FAILED) {
+            goto fail;
+        }
+
+        uring->sqRing = mapping;
+
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            uring->cqRing = uring->sqRing;
+        } else {
+            mapping = mmap(NULL, uring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+            if (mapping == MAP_FAILED) {
+                goto fail;
+            }
+
+            uring->cqRing = mapping;
+        }
+
+        uring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        mapping = mmap(NULL, uring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+        if (mapping == MAP_FAILED) {
+            goto fail;
+        }
+
+        uring->sqes = (struct io_uring_sqe *) mapping;
+
+        uring->sqHead      = (unsigned *) ((char *) uring->sqRing + params.sq_off.head);
+        uring->sqTail      = (unsigned *) ((char *) uring->sqRing + params.sq_off.tail);
+        uring->sqArray     = (unsigned *) ((char *) uring->sqRing + params.sq_off.array);
+        uring->sqMask      = *(unsigned *) ((char *) uring->sqRing + params.sq_off.ring_mask);
+        uring->sqEntries   = params.sq_entries;
+        uring->sqLocalTail = *uring->sqTail;
+
+        uring->cqHead = (unsigned *) ((char *) uring->cqRing + params.cq_off.head);
+        uring->cqTail = (unsigned *) ((char *) uring->cqRing + params.cq_off.tail);
+        uring->cqMask = *(unsigned *) ((char *) uring->cqRing + params.cq_off.ring_mask);
+        uring->cqes   = (struct io_uring_cqe *) ((char *) uring->cqRing + params.cq_off.cqes);
+
+        /* the receive buffers, and the ring the kernel takes them from, which has to be page aligned */
+        uring->buffers = (enet_uint8 *) enet_malloc(ENET_URING_RECEIVE_BUFFERS * ENET_URING_BUFFER_SIZE);
+        uring->sends   = (ENetUringSend *) enet_malloc(ENET_URING_SEND_SLOTS * sizeof(ENetUringSend));
+        if (uring->buffers == NULL || uring->sends == NULL) {
+            goto fail;
+        }
+
+        uring->bufferRingSize = ENET_URING_RECEIVE_BUFFERS * sizeof(struct io_uring_buf);
+        mapping = mmap(NULL, uring->bufferRingSize, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+        if (mapping == MAP_FAILED) {
+            goto fail;
+        }
+
+        uring->bufferRing = (struct io_uring_buf_ring *) mapping;
+
+        memset(&bufferRegister, 0, sizeof(bufferRegister));
+        bufferRegister.ring_addr    = (enet_uint64) (uintptr_t) uring->bufferRing;
+        bufferRegister.ring_entries = ENET_URING_RECEIVE_BUFFERS;
+        bufferRegister.bgid         = ENET_URING_BUFFER_GROUP;
+
+        if (enet_uring_register(uring->fd, IORING_REGISTER_PBUF_RING, &bufferRegister, 1) < 0) {
+            goto fail;
+        }
+
+        for (i = 0; i < ENET_URING_RECEIVE_BUFFERS; ++i) {
+            enet_uring_return_buffer(uring, i);
+        }
+
+        for (i = 0; i < ENET_URING_SEND_SLOTS; ++i) {
+            uring->freeSends[i] = ENET_URING_SEND_SLOTS - 1 - i;
+        }
+
+        uring->freeSendCount = ENET_URING_SEND_SLOTS;
+
+        /* older kernels reject multishot receives when they are submitted, so try one and take it down again
+         * the real one is posted by the first receive, so its work runs on the thread that services the host
+         */
+        if (enet_uring_arm_receive(uring) < 0 || enet_uring_submit(uring, 0) < 0 || enet_uring_reap(uring) < 0 || !uring->receiveArmed) {
+            goto fail;
+        }
+
+        enet_uring_drain(uring);
+        return uring;
+
+    fail:
+        enet_uring_destroy(uring);
+        return NULL;
+    }
+
+    /** Takes the next datagram the kernel has received.
+     *  Returns the same as enet_socket_receive, and points host->receivedData at the datagram.
+     */
+    static int enet_protocol_receive_uring(ENetHost *host) {
+        ENetUring *uring = host->uring;
+        struct io_uring_recvmsg_out *out;
+        struct sockaddr_in6 *sin;
+        enet_uint8 *buffer;
+
+        /* the last datagram has been handled, so its buffer can be filled again */
+        if (uring->heldBuffer >= 0) {
+            enet_uring_return_buffer(uring, uring->heldBuffer);
+            uring->heldBuffer = -1;
+        }
+
+        if (uring->readyHead == uring->readyTail) {
+            enet_uring_reap(uring);
+        }
+
+        if (uring->readyHead == uring->readyTail) {
+            /* it stops when it runs out of buffers, and the ones we had are back now */
+            if (!uring->receiveArmed && (enet_uring_arm_receive(uring) < 0 || enet_uring_submit(uring, 0) < 0)) {
+                return -1;
+            }
+
+            return 0;
+        }
+
+        uring->heldBuffer = uring->ready[uring->readyHead++ & (ENET_URING_RECEIVE_BUFFERS - 1)];
+        buffer = uring->buffers + (size_t) uring->heldBuffer * ENET_URING_BUFFER_SIZE;
+        out    = (struct io_uring_recvmsg_out *) buffer;
+
+        if ((out->flags & MSG_TRUNC) || out->namelen > sizeof(struct sockaddr_in6)) {
+            return -2;
+        }
+
+        sin = (struct sockaddr_in6 *) (buffer + sizeof(struct io_uring_recvmsg_out));
+        host->receivedAddress.host          = sin->sin6_addr;
+        host->receivedAddress.port          = ENET_NET_TO_HOST_16(sin->sin6_port);
+        host->receivedAddress.sin6_scope_id = sin->sin6_scope_id;
+        host->receivedData = buffer + sizeof(struct io_uring_recvmsg_out) + uring->receiveMessage.msg_namelen + uring->receiveMessage.msg_controllen;
+
+        return (int) out->payloadlen;
+    } /* enet_protocol_receive_uring */
+
+    /** Copies the datagram in the host's buffers into a send slot and queues it, it is submitted when the host is flushed.
+     *  Returns the length of the datagram, or -1 on error.
+     */
+    static int enet_protocol_queue_uring_send(ENetHost *host, const ENetAddress *address) {
+        ENetUring *uring = host->uring;
+        struct io_uring_sqe *sqe;
+        ENetUringSend *send;
+        size_t i, length = 0;
+        int slot, tries;
+
+        /* every slot is still being sent, so wait for some to finish */
+        for (tries = 0; uring->freeSendCount == 0; ++tries) {
+            if (tries > 100 || enet_uring_submit(uring, 1) < 0) {
+                return -1;
+            }
+
+            enet_uring_reap(uring);
+        }
+
+        slot = uring->freeSends[uring->freeSendCount - 1];
+        send = &uring->sends[slot];
+
+        for (i = 0; i < host->bufferCount; ++i) {
+            if (length + host->buffers[i].dataLength > ENET_PROTOCOL_MAXIMUM_MTU) {
+                return -1;
+            }
+
+            memcpy(send->data + length, host->buffers[i].data, host->buffers[i].dataLength);
+            length += host->buffers[i].dataLength;
+        }
+
+        sqe = enet_uring_get_sqe(uring);
+        if (sqe == NULL) {
+            return -1;
+        }
+
+        uring->freeSendCount--;
+
+        memset(&send->address, 0, sizeof(struct sockaddr_in6));
+        send->address.sin6_family   = AF_INET6;
+        send->address.sin6_port     = ENET_HOST_TO_NET_16(address->port);
+        send->address.sin6_addr     = address->host;
+        send->address.sin6_scope_id = address->sin6_scope_id;
+
+        send->vector.iov_base = send->data;
+        send->vector.iov_len  = length;
+
+        memset(&send->message, 0, sizeof(struct msghdr));
+        send->message.msg_name    = &send->address;
+        send->message.msg_namelen = sizeof(struct sockaddr_in6);
+        send->message.msg_iov     = &send->vector;
+        send->message.msg_iovlen  = 1;
+
+        sqe->opcode    = IORING_OP_SENDMSG;
+        sqe->fd        = uring->socket;
+        sqe->addr      = (enet_uint64) (uintptr_t) &send->message;
+        sqe->len       = 1;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = (enet_uint64) slot;
+
+        return (int) length;
+    } /* enet_protocol_queue_uring_send */
+    #endif
+
     static int enet_protocol_receive_incoming_commands(ENetHost *host, ENetEvent *event) {
         int packets;
 
@@ -2685,11 +3494,24 @@ extern "C" {
             int receivedLength;
             ENetBuffer buffer;
 
-            buffer.data       = host->packetData[0];
-            // buffer.dataLength = sizeof (host->packetData[0]);
-            buffer.dataLength = host->mtu;
+            #ifdef ENET_USE_IO_URING
+            if (host->uring != NULL) {
+                receivedLength = enet_protocol_receive_uring(host);
+            } else
+            #endif
+            #ifdef ENET_USE_RECVMMSG
+            if (host->receiveBatch != NULL) {
+                receivedLength = enet_protocol_receive_batched(host);
+            } else
+            #endif
+            {
+                buffer.data       = host->packetData[0];
+                // buffer.dataLength = sizeof (host->packetData[0]);
+                buffer.dataLength = host->mtu;
 
-            receivedLength    = enet_socket_receive(host->socket, &host->receivedAddress, &buffer, 1);
+                receivedLength    = enet_socket_receive(host->socket, &host->receivedAddress, &buffer, 1);
+                host->receivedData = host->packetData[0];
+            }
 
             if (receivedLength == -2)
                 continue;
@@ -2702,7 +3524,6 @@ extern "C" {
                 return 0;
             }
 
-            host->receivedData       = host->packetData[0];
             host->receivedDataLength = receivedLength;
 
             host->totalReceivedData += receivedLength;
@@ -2778,7 +3599,7 @@ extern "C" {
             }
 
             enet_list_remove(&acknowledgement->acknowledgementList);
-            enet_free(acknowledgement);
+            enet_host_command_free(host, acknowledgement);
 
             ++command;
             ++buffer;
@@ -2828,7 +3649,7 @@ extern "C" {
                         }
 
                         enet_list_remove(&outgoingCommand->outgoingCommandList);
-                        enet_free(outgoingCommand);
+                        enet_host_command_free(host, outgoingCommand);
 
                         if (currentCommand == enet_list_end(&peer->outgoingUnreliableCommands)) {
                             break;
@@ -2862,7 +3683,7 @@ extern "C" {
 
                 enet_list_insert(enet_list_end(&peer->sentUnreliableCommands), outgoingCommand);
             } else {
-                enet_free(outgoingCommand);
+                enet_host_command_free(host, outgoingCommand);
             }
 
             ++command;
@@ -3047,6 +3868,107 @@ extern "C" {
         return canPing;
     } /* enet_protocol_send_reliable_outgoing_commands */
 
+    #ifdef ENET_USE_SENDMMSG
+    /** Datagrams made during one call to enet_protocol_send_outgoing_commands, sent together with sendmmsg.
+     *  Each one is copied in, because the packets it was made from can be freed as soon as it is queued.
+     */
+    typedef struct _ENetSendBatch {
+        struct mmsghdr      messages[ENET_HOST_SEND_BATCH];
+        struct iovec        vectors[ENET_HOST_SEND_BATCH];
+        struct sockaddr_in6 addresses[ENET_HOST_SEND_BATCH];
+        int                 count;
+        enet_uint8          data[ENET_HOST_SEND_BATCH][ENET_PROTOCOL_MAXIMUM_MTU];
+    } ENetSendBatch;
+
+    /** Sends every datagram in the host's send batch.
+     *  Like enet_socket_send, datagrams the socket has no room for are dropped. Returns -1 on any other error.
+     */
+    static int enet_protocol_flush_send_batch(ENetHost *host) {
+        ENetSendBatch *batch = host->sendBatch;
+        int sent = 0;
+
+        while (sent < batch->count) {
+            int result = sendmmsg(host->socket, &batch->messages[sent], batch->count - sent, MSG_NOSIGNAL);
+
+            if (result == -1) {
+                if (errno == EWOULDBLOCK || errno == EAGAIN) {
+                    break;
+                }
+
+                batch->count = 0;
+                return -1;
+            }
+
+            sent += result;
+        }
+
+        batch->count = 0;
+        return 0;
+    } /* enet_protocol_flush_send_batch */
+
+    /** Copies the datagram in the host's buffers into the send batch, sending the batch first if it is full.
+     *  Returns the length of the datagram, or -1 on error.
+     */
+    static int enet_protocol_queue_datagram(ENetHost *host, const ENetAddress *address) {
+        ENetSendBatch *batch = host->sendBatch;
+        struct sockaddr_in6 *sin;
+        enet_uint8 *data;
+        size_t i, length = 0;
+
+        if (batch->count >= ENET_HOST_SEND_BATCH && enet_protocol_flush_send_batch(host) < 0) {
+            return -1;
+        }
+
+        data = batch->data[batch->count];
+        for (i = 0; i < host->bufferCount; ++i) {
+            if (length + host->buffers[i].dataLength > ENET_PROTOCOL_MAXIMUM_MTU) {
+                return -1;
+            }
+
+            memcpy(data + length, host->buffers[i].data, host->buffers[i].dataLength);
+            length += host->buffers[i].dataLength;
+        }
+
+        sin = &batch->addresses[batch->count];
+        memset(sin, 0, sizeof(struct sockaddr_in6));
+        sin->sin6_family   = AF_INET6;
+        sin->sin6_port     = ENET_HOST_TO_NET_16(address->port);
+        sin->sin6_addr     = address->host;
+        sin->sin6_scope_id = address->sin6_scope_id;
+
+        batch->vectors[batch->count].iov_base = data;
+        batch->vectors[batch->count].iov_len  = length;
+
+        memset(&batch->messages[batch->count], 0, sizeof(struct mmsghdr));
+        batch->messages[batch->count].msg_hdr.msg_name    = sin;
+        batch->messages[batch->count].msg_hdr.msg_namelen = sizeof(struct sockaddr_in6);
+        batch->messages[batch->count].msg_hdr.msg_iov     = &batch->vectors[batch->count];
+        batch->messages[batch->count].msg_hdr.msg_iovlen  = 1;
+
+        batch->count++;
+        return (int) length;
+    } /* enet_protocol_queue_datagram */
+    #endif
+
+    /** Sends what is waiting in the host's send batch or io_uring, if it has one. */
+    static int enet_protocol_send_batched(ENetHost *host) {
+        ENET_UNUSED(host)
+
+        #ifdef ENET_USE_IO_URING
+        if (host->uring != NULL) {
+            return enet_uring_submit(host->uring, 0);
+        }
+        #endif
+
+        #ifdef ENET_USE_SENDMMSG
+        if (host->sendBatch != NULL && host->sendBatch->count > 0) {
+            return enet_protocol_flush_send_batch(host);
+        }
+        #endif
+
+        return 0;
+    }
+
     static int enet_protocol_send_outgoing_commands(ENetHost *host, ENetEvent *event, int checkForTimeouts) {
         enet_uint8 headerData[sizeof(ENetProtocolHeader) + sizeof(enet_uint32)];
         ENetProtocolHeader *header = (ENetProtocolHeader *) headerData;
@@ -3076,7 +3998,7 @@ extern "C" {
                     enet_protocol_check_timeouts(host, currentPeer, event) == 1
                 ) {
                     if (event != NULL && event->type != ENET_EVENT_TYPE_NONE) {
-                        return 1;
+                        return enet_protocol_send_batched(host) < 0 ? -1 : 1;
                     } else {
                         continue;
                     }
@@ -3172,7 +4094,19 @@ extern "C" {
                 }
 
                 currentPeer->lastSendTime = host->serviceTime;
-                sentLength = enet_socket_send(host->socket, &currentPeer->address, host->buffers, host->bufferCount);
+                #ifdef ENET_USE_IO_URING
+                if (host->uring != NULL) {
+                    sentLength = enet_protocol_queue_uring_send(host, &currentPeer->address);
+                } else
+                #endif
+                #ifdef ENET_USE_SENDMMSG
+                if (host->sendBatch != NULL) {
+                    sentLength = enet_protocol_queue_datagram(host, &currentPeer->address);
+                } else
+                #endif
+                {
+                    sentLength = enet_socket_send(host->socket, &currentPeer->address, host->buffers, host->bufferCount);
+                }
                 enet_protocol_remove_sent_unreliable_commands(currentPeer);
 
                 if (sentLength < 0) {
@@ -3184,7 +4118,7 @@ extern "C" {
                 host->totalSentPackets++;
             }
 
-        return 0;
+        return enet_protocol_send_batched(host);
     } /* enet_protocol_send_outgoing_commands */
 
     /** Sends any queued packets on the host specified to its designated peers.
@@ -3336,7 +4270,7 @@ extern "C" {
                 }
 
                 waitCondition = ENET_SOCKET_WAIT_RECEIVE | ENET_SOCKET_WAIT_INTERRUPT;
-                if (enet_socket_wait(host->socket, &waitCondition, ENET_TIME_DIFFERENCE(timeout, host->serviceTime)) != 0) {
+                if (enet_socket_wait(enet_host_get_wait_socket(host), &waitCondition, ENET_TIME_DIFFERENCE(timeout, host->serviceTime)) != 0) {
                     return -1;
                 }
             } while (waitCondition & ENET_SOCKET_WAIT_INTERRUPT);
@@ -3567,13 +4501,13 @@ extern "C" {
                     fragmentLength = packet->dataLength - fragmentOffset;
                 }
 
-                fragment = (ENetOutgoingCommand *) enet_malloc(sizeof(ENetOutgoingCommand));
+                fragment = (ENetOutgoingCommand *) enet_host_command_malloc(peer->host);
 
                 if (fragment == NULL) {
                     while (!enet_list_empty(&fragments)) {
                         fragment = (ENetOutgoingCommand *) enet_list_remove(enet_list_begin(&fragments));
 
-                        enet_free(fragment);
+                        enet_host_command_free(peer->host, fragment);
                     }
 
                     return -1;
@@ -3654,13 +4588,13 @@ extern "C" {
             enet_free(incomingCommand->fragments);
         }
 
-        enet_free(incomingCommand);
+        enet_host_command_free(peer->host, incomingCommand);
         peer->totalWaitingData -= packet->dataLength;
 
         return packet;
     }
 
-    static void enet_peer_reset_outgoing_commands(ENetList *queue) {
+    static void enet_peer_reset_outgoing_commands(ENetHost *host, ENetList *queue) {
         ENetOutgoingCommand *outgoingCommand;
 
         while (!enet_list_empty(queue)) {
@@ -3674,11 +4608,11 @@ extern "C" {
                 }
             }
 
-            enet_free(outgoingCommand);
+            enet_host_command_free(host, outgoingCommand);
         }
     }
 
-    static void enet_peer_remove_incoming_commands(ENetList *queue, ENetListIterator startCommand, ENetListIterator endCommand) {
+    static void enet_peer_remove_incoming_commands(ENetHost *host, ENetList *queue, ENetListIterator startCommand, ENetListIterator endCommand) {
         ENET_UNUSED(queue)
 
         ENetListIterator currentCommand;
@@ -3701,12 +4635,12 @@ extern "C" {
                 enet_free(incomingCommand->fragments);
             }
 
-            enet_free(incomingCommand);
+            enet_host_command_free(host, incomingCommand);
         }
     }
 
-    static void enet_peer_reset_incoming_commands(ENetList *queue) {
-        enet_peer_remove_incoming_commands(queue, enet_list_begin(queue), enet_list_end(queue));
+    static void enet_peer_reset_incoming_commands(ENetHost *host, ENetList *queue) {
+        enet_peer_remove_incoming_commands(host, queue, enet_list_begin(queue), enet_list_end(queue));
     }
 
     void enet_peer_reset_queues(ENetPeer *peer) {
@@ -3718,19 +4652,19 @@ extern "C" {
         }
 
         while (!enet_list_empty(&peer->acknowledgements)) {
-            enet_free(enet_list_remove(enet_list_begin(&peer->acknowledgements)));
+            enet_host_command_free(peer->host, enet_list_remove(enet_list_begin(&peer->acknowledgements)));
         }
 
-        enet_peer_reset_outgoing_commands(&peer->sentReliableCommands);
-        enet_peer_reset_outgoing_commands(&peer->sentUnreliableCommands);
-        enet_peer_reset_outgoing_commands(&peer->outgoingReliableCommands);
-        enet_peer_reset_outgoing_commands(&peer->outgoingUnreliableCommands);
-        enet_peer_reset_incoming_commands(&peer->dispatchedCommands);
+        enet_peer_reset_outgoing_commands(peer->host, &peer->sentReliableCommands);
+        enet_peer_reset_outgoing_commands(peer->host, &peer->sentUnreliableCommands);
+        enet_peer_reset_outgoing_commands(peer->host, &peer->outgoingReliableCommands);
+        enet_peer_reset_outgoing_commands(peer->host, &peer->outgoingUnreliableCommands);
+        enet_peer_reset_incoming_commands(peer->host, &peer->dispatchedCommands);
 
         if (peer->channels != NULL && peer->channelCount > 0) {
             for (channel = peer->channels; channel < &peer->channels[peer->channelCount]; ++channel) {
-                enet_peer_reset_incoming_commands(&channel->incomingReliableCommands);
-                enet_peer_reset_incoming_commands(&channel->incomingUnreliableCommands);
+                enet_peer_reset_incoming_commands(peer->host, &channel->incomingReliableCommands);
+                enet_peer_reset_incoming_commands(peer->host, &channel->incomingUnreliableCommands);
             }
 
             enet_free(peer->channels);
@@ -3982,7 +4916,7 @@ extern "C" {
             }
         }
 
-        acknowledgement = (ENetAcknowledgement *) enet_malloc(sizeof(ENetAcknowledgement));
+        acknowledgement = (ENetAcknowledgement *) enet_host_command_malloc(peer->host);
         if (acknowledgement == NULL) {
             return NULL;
         }
@@ -4055,7 +4989,7 @@ extern "C" {
     }
 
     ENetOutgoingCommand * enet_peer_queue_outgoing_command(ENetPeer *peer, const ENetProtocol *command, ENetPacket *packet, enet_uint32 offset, enet_uint16 length) {
-        ENetOutgoingCommand *outgoingCommand = (ENetOutgoingCommand *) enet_malloc(sizeof(ENetOutgoingCommand));
+        ENetOutgoingCommand *outgoingCommand = (ENetOutgoingCommand *) enet_host_command_malloc(peer->host);
 
         if (outgoingCommand == NULL) {
             return NULL;
@@ -4142,7 +5076,7 @@ extern "C" {
             droppedCommand = currentCommand;
         }
 
-        enet_peer_remove_incoming_commands(&channel->incomingUnreliableCommands,enet_list_begin(&channel->incomingUnreliableCommands), droppedCommand);
+        enet_peer_remove_incoming_commands(peer->host, &channel->incomingUnreliableCommands,enet_list_begin(&channel->incomingUnreliableCommands), droppedCommand);
     }
 
     void enet_peer_dispatch_incoming_reliable_commands(ENetPeer *peer, ENetChannel *channel) {
@@ -4302,7 +5236,7 @@ extern "C" {
             goto notifyError;
         }
 
-        incomingCommand = (ENetIncomingCommand *) enet_malloc(sizeof(ENetIncomingCommand));
+        incomingCommand = (ENetIncomingCommand *) enet_host_command_malloc(peer->host);
         if (incomingCommand == NULL) {
             goto notifyError;
         }
@@ -4321,7 +5255,7 @@ extern "C" {
             }
 
             if (incomingCommand->fragments == NULL) {
-                enet_free(incomingCommand);
+                enet_host_command_free(peer->host, incomingCommand);
 
                 goto notifyError;
             }
@@ -4472,6 +5406,19 @@ extern "C" {
         host->compressor.decompress         = NULL;
         host->compressor.destroy            = NULL;
         host->intercept                     = NULL;
+        host->receiveBatch                  = NULL;
+        host->sendBatch                     = NULL;
+        host->uring                         = NULL;
+        host->commandPool                   = NULL;
+
+        #ifdef ENET_USE_RECVMMSG
+        /* if this can't be allocated, datagrams are just read one at a time */
+        host->receiveBatch = (ENetReceiveBatch *) enet_malloc(sizeof(ENetReceiveBatch));
+        if (host->receiveBatch != NULL) {
+            host->receiveBatch->count = 0;
+            host->receiveBatch->next  = 0;
+        }
+        #endif
 
         enet_list_clear(&host->dispatchQueue);
 
@@ -4504,6 +5451,10 @@ extern "C" {
             return;
         }
 
+        #ifdef ENET_USE_IO_URING
+        enet_uring_destroy(host->uring);
+        #endif
+
         enet_socket_destroy(host->socket);
 
         for (currentPeer = host->peers; currentPeer < &host->peers[host->peerCount]; ++currentPeer) {
@@ -4514,6 +5465,16 @@ extern "C" {
             (*host->compressor.destroy)(host->compressor.context);
         }
 
+        if (host->receiveBatch != NULL) {
+            enet_free(host->receiveBatch);
+        }
+
+        if (host->sendBatch != NULL) {
+            enet_free(host->sendBatch);
+        }
+
+        enet_host_command_pool_destroy(host->commandPool);
+
         enet_free(host->peers);
         enet_free(host);
     }
@@ -4697,6 +5658,121 @@ extern "C" {
         host->channelLimit = channelLimit;
     }
 
+    /** Turns batched sending on or off for a host.
+     *  With it on, every datagram made while sending the host's queued commands is sent with one sendmmsg call
+     *  instead of one sendmsg call each.
+     *  @param host host to change
+     *  @param enable 1 to turn batching on, 0 to turn it off
+     *  @returns 0 on success, -1 if batching is not available on this platform or could not be allocated
+     */
+    int enet_host_set_send_batching(ENetHost *host, int enable) {
+        if (!enable) {
+            if (host->sendBatch != NULL) {
+                enet_free(host->sendBatch);
+                host->sendBatch = NULL;
+            }
+
+            return 0;
+        }
+
+        #ifdef ENET_USE_SENDMMSG
+        if (host->sendBatch == NULL) {
+            host->sendBatch = (ENetSendBatch *) enet_malloc(sizeof(ENetSendBatch));
+            if (host->sendBatch == NULL) {
+                return -1;
+            }
+
+            host->sendBatch->count = 0;
+        }
+
+        return 0;
+        #else
+        return -1;
+        #endif
+    }
+
+    /** Turns reuse of command and acknowledgement nodes on or off for a host.
+     *  With it on, the nodes freed once their datagram is acknowledged or their packet is handed out are kept on a list
+     *  and handed back the next time one is needed, instead of going through enet_malloc and enet_free every time.
+     *  @param host host to change
+     *  @param enable 1 to keep freed nodes, 0 to release them and stop
+     *  @returns 0 on success, -1 if the pool could not be allocated
+     */
+    int enet_host_set_command_pool(ENetHost *host, int enable) {
+        if (!enable) {
+            enet_host_command_pool_destroy(host->commandPool);
+            host->commandPool = NULL;
+            return 0;
+        }
+
+        if (host->commandPool == NULL) {
+            host->commandPool = (ENetCommandPool *) enet_malloc(sizeof(ENetCommandPool));
+            if (host->commandPool == NULL) {
+                return -1;
+            }
+
+            memset(host->commandPool, 0, sizeof(ENetCommandPool));
+        }
+
+        return 0;
+    }
+
+    /** Reads the counters of a host's command pool, they are all zero while it is off.
+     *  @param host host to read
+     *  @param stats filled in with the counters
+     */
+    void enet_host_get_command_pool_stats(ENetHost *host, ENetPoolStats *stats) {
+        memset(stats, 0, sizeof(ENetPoolStats));
+
+        if (host->commandPool != NULL) {
+            stats->hits   = host->commandPool->hits;
+            stats->misses = host->commandPool->misses;
+            stats->cached = host->commandPool->count;
+        }
+    }
+
+    /** Moves a host's socket reads and writes onto an io_uring, or back off it.
+     *  With it on, a multishot receive stays posted with buffers the kernel fills as datagrams come in,
+     *  and the datagrams made while sending are submitted together, so neither needs a system call per datagram.
+     *  This should be done before the host is serviced, and only the thread that services it should use it after.
+     *  @param host host to change
+     *  @param enable 1 to use io_uring, 0 to go back to normal socket calls
+     *  @returns 0 on success, -1 if io_uring is not available on this platform or kernel, the host is left as it was
+     */
+    int enet_host_set_io_uring(ENetHost *host, int enable) {
+        #ifdef ENET_USE_IO_URING
+        if (!enable) {
+            enet_uring_destroy(host->uring);
+            host->uring = NULL;
+            return 0;
+        }
+
+        if (host->uring == NULL) {
+            host->uring = enet_uring_create(host->socket);
+            if (host->uring == NULL) {
+                return -1;
+            }
+        }
+
+        return 0;
+        #else
+        return enable ? -1 : 0;
+        #endif
+    }
+
+    /** Gets what to wait on to know when a host has something to read.
+     *  This is the host's socket, unless it is using io_uring, then it is the ring, which is readable when something completes.
+     */
+    ENetSocket enet_host_get_wait_socket(ENetHost *host) {
+        #ifdef ENET_USE_IO_URING
+        if (host->uring != NULL) {
+            return host->uring->fd;
+        }
+        #endif
+
+        return host->socket;
+    }
+
     /** Adjusts the bandwidth limits of a host.
      *  @param host host to adjust
      *  @param incomingBandwidth new incoming bandwidth
@@ -5504,6 +6580,13 @@ extern "C" {
                 result = setsockopt(socket, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&value, sizeof(int));
                 break;
 
+            /* lets several sockets bind the same port, it must be set before binding */
+            case ENET_SOCKOPT_REUSEPORT:
+                #ifdef SO_REUSEPORT
+                result = setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, (char *)&value, sizeof(int));
+                #endif
+                break;
+
             default:
                 break;
         }
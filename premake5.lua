@@ -81,11 +81,11 @@ project "client"
 		["Header Files"] = { "**.h"},
 		["Source Files"] = {"**.c", "**.cpp"},
 	}
-	files {"client/**.c", "client/**.cpp", "client/**.h"}
+	files {"client/**.c", "client/**.cpp", "client/**.h", "common/**.c", "common/**.h"}
 
 	links {"raylib"}
 	
-	includedirs { "client", "include", "raylib/src" }
+	includedirs { "client", "common", "include", "raylib/src" }
 	
 	defines{"PLATFORM_DESKTOP"}
 	if (_OPTIONS["opengl43"]) then
@@ -120,11 +120,11 @@ project "server"
 		["Header Files"] = { "**.h"},
 		["Source Files"] = {"**.c", "**.cpp"},
 	}
-	files {"server/**.c", "server/**.cpp", "server/**.h"}
+	files {"server/**.c", "server/**.cpp", "server/**.h", "common/**.c", "common/**.h"}
 
 	links {"raylib"}
 	
-	includedirs { "server", "include", "raylib/src" }
+	includedirs { "server", "common", "include", "raylib/src" }
 	
 	defines{"PLATFORM_DESKTOP"}
 	if (_OPTIONS["opengl43"]) then
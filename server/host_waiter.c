@@ -0,0 +1,180 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the host waiter
+
+// ensure we are using winsock2 on windows.
+#if (_WIN32_WINNT < 0x0601)
+	#undef _WIN32_WINNT
+    #define _WIN32_WINNT 0x0601
+#endif
+
+#include "host_waiter.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// the epoll data for the wake up eventfd, hosts use their index
+#define WAKE_EVENT_DATA 0xFFFFFFFFu
+
+bool HostWaiterInit(HostWaiter* waiter)
+{
+    waiter->HostCount = 0;
+    waiter->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    waiter->WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (waiter->EpollFd < 0 || waiter->WakeFd < 0)
+    {
+        HostWaiterFree(waiter);
+        return false;
+    }
+
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN;
+    event.data.u32 = WAKE_EVENT_DATA;
+    if (epoll_ctl(waiter->EpollFd, EPOLL_CTL_ADD, waiter->WakeFd, &event) < 0)
+    {
+        HostWaiterFree(waiter);
+        return false;
+    }
+
+    return true;
+}
+
+void HostWaiterFree(HostWaiter* waiter)
+{
+    if (waiter->EpollFd >= 0)
+        close(waiter->EpollFd);
+
+    if (waiter->WakeFd >= 0)
+        close(waiter->WakeFd);
+
+    waiter->EpollFd = -1;
+    waiter->WakeFd = -1;
+    waiter->HostCount = 0;
+}
+
+bool HostWaiterAdd(HostWaiter* waiter, ENetHost* host)
+{
+    if (waiter->HostCount >= HOST_WAITER_MAX_HOSTS)
+        return false;
+
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN;
+    event.data.u32 = (uint32_t)waiter->HostCount;
+    if (epoll_ctl(waiter->EpollFd, EPOLL_CTL_ADD, enet_host_get_wait_socket(host), &event) < 0)
+        return false;
+
+    waiter->Hosts[waiter->HostCount++] = host;
+    return true;
+}
+
+bool HostWaiterWait(HostWaiter* waiter, uint32_t timeout)
+{
+    struct epoll_event events[HOST_WAITER_MAX_HOSTS + 1];
+    int count = epoll_wait(waiter->EpollFd, events, HOST_WAITER_MAX_HOSTS + 1, (int)timeout);
+    if (count < 0)
+        return errno == EINTR;
+
+    // the hosts are left for the caller to read, but the wake up has to be cleared here or we'd never sleep again
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data.u32 == WAKE_EVENT_DATA)
+        {
+            uint64_t value;
+            if (read(waiter->WakeFd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void HostWaiterWake(HostWaiter* waiter)
+{
+    uint64_t value = 1;
+    if (write(waiter->WakeFd, &value, sizeof(value)) < 0)
+    {
+        // the counter is full, so there is already a wake up waiting
+    }
+}
+
+#else
+
+bool HostWaiterInit(HostWaiter* waiter)
+{
+    waiter->HostCount = 0;
+    return true;
+}
+
+void HostWaiterFree(HostWaiter* waiter)
+{
+    waiter->HostCount = 0;
+}
+
+bool HostWaiterAdd(HostWaiter* waiter, ENetHost* host)
+{
+    if (waiter->HostCount >= HOST_WAITER_MAX_HOSTS)
+        return false;
+
+    waiter->Hosts[waiter->HostCount++] = host;
+    return true;
+}
+
+bool HostWaiterWait(HostWaiter* waiter, uint32_t timeout)
+{
+    // nothing can wake us up early, so don't sleep long
+    if (timeout > HOST_WAITER_POLL_INTERVAL)
+        timeout = HOST_WAITER_POLL_INTERVAL;
+
+    ENetSocketSet readSet;
+    ENET_SOCKETSET_EMPTY(readSet);
+
+    ENetSocket maxSocket = 0;
+    for (int i = 0; i < waiter->HostCount; i++)
+    {
+        ENetSocket socket = enet_host_get_wait_socket(waiter->Hosts[i]);
+        ENET_SOCKETSET_ADD(readSet, socket);
+        if (socket > maxSocket)
+            maxSocket = socket;
+    }
+
+    return enet_socketset_select(maxSocket, &readSet, NULL, timeout) >= 0;
+}
+
+void HostWaiterWake(HostWaiter* waiter)
+{
+    // waits are never longer than HOST_WAITER_POLL_INTERVAL, so there is nothing to do
+    (void)waiter;
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Waits until one of a set of enet hosts has data to read, a timeout passes, or another thread wakes it up
+// On Linux this is an epoll set with the host sockets and an eventfd for wake ups, so a network thread can sleep
+// until there is something to do instead of checking every millisecond, and one thread can look after many hosts.
+// Everywhere else it uses select on the host sockets, and since nothing can interrupt that,
+// it never sleeps longer than HOST_WAITER_POLL_INTERVAL.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "enet.h"
+
+// the most hosts one waiter can wait on
+#define HOST_WAITER_MAX_HOSTS 64
+
+// the longest (in milliseconds) a wait can be where it can't be woken up
+#define HOST_WAITER_POLL_INTERVAL 1
+
+// the hosts to wait on and what to wait with
+typedef struct
+{
+    int HostCount;
+    ENetHost* Hosts[HOST_WAITER_MAX_HOSTS];
+
+#ifdef __linux__
+    int EpollFd;
+    int WakeFd;
+#endif
+}HostWaiter;
+
+// set up a waiter with no hosts
+// returns false if it could not be set up
+bool HostWaiterInit(HostWaiter* waiter);
+
+// release a waiter, this does not touch the hosts
+void HostWaiterFree(HostWaiter* waiter);
+
+// add a host to wait on, after it has picked how it does its socket calls (io_uring or not)
+// returns false if there is no room for it
+bool HostWaiterAdd(HostWaiter* waiter, ENetHost* host);
+
+// wait until a host has data to read, the waiter is woken or timeout milliseconds have passed
+// the caller should service all of its hosts after this returns, no matter why it returned
+// returns false if waiting failed
+bool HostWaiterWait(HostWaiter* waiter, uint32_t timeout);
+
+// wake up a thread waiting on this waiter, or make its next wait return right away
+// this can be called from any thread
+void HostWaiterWake(HostWaiter* waiter);
@@ -0,0 +1,175 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the area of interest grid
+
+#include "interest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool InterestGridInit(InterestGrid* grid, int fieldWidth, int fieldHeight, int cellSize, int capacity)
+{
+    memset(grid, 0, sizeof(InterestGrid));
+
+    if (cellSize < 1)
+        cellSize = 1;
+
+    grid->CellSize = cellSize;
+    grid->Columns = (fieldWidth + cellSize - 1) / cellSize;
+    grid->Rows = (fieldHeight + cellSize - 1) / cellSize;
+    grid->Capacity = capacity;
+
+    grid->Pending = (InterestEntry*)malloc(sizeof(InterestEntry) * capacity);
+    grid->Entries = (InterestEntry*)malloc(sizeof(InterestEntry) * capacity);
+    grid->CellStart = (int*)calloc((size_t)grid->Columns * grid->Rows + 1, sizeof(int));
+
+    if (grid->Pending == NULL || grid->Entries == NULL || grid->CellStart == NULL)
+    {
+        InterestGridFree(grid);
+        return false;
+    }
+
+    return true;
+}
+
+void InterestGridFree(InterestGrid* grid)
+{
+    free(grid->Pending);
+    free(grid->Entries);
+    free(grid->CellStart);
+    memset(grid, 0, sizeof(InterestGrid));
+}
+
+void InterestGridClear(InterestGrid* grid)
+{
+    grid->Count = 0;
+}
+
+// find the cell a location is in, anything outside the field is put in the closest edge cell
+static int GetCellIndex(const InterestGrid* grid, int x, int y)
+{
+    int column = x / grid->CellSize;
+    int row = y / grid->CellSize;
+
+    if (column < 0)
+        column = 0;
+    if (column >= grid->Columns)
+        column = grid->Columns - 1;
+    if (row < 0)
+        row = 0;
+    if (row >= grid->Rows)
+        row = grid->Rows - 1;
+
+    return row * grid->Columns + column;
+}
+
+void InterestGridAdd(InterestGrid* grid, int id, int16_t x, int16_t y)
+{
+    if (grid->Count >= grid->Capacity)
+        return;
+
+    InterestEntry* entry = &grid->Pending[grid->Count++];
+    entry->Id = id;
+    entry->X = x;
+    entry->Y = y;
+}
+
+void InterestGridBuild(InterestGrid* grid)
+{
+    int cellCount = grid->Columns * grid->Rows;
+
+    // count how many players are in each cell
+    memset(grid->CellStart, 0, sizeof(int) * (cellCount + 1));
+    for (int i = 0; i < grid->Count; i++)
+        grid->CellStart[GetCellIndex(grid, grid->Pending[i].X, grid->Pending[i].Y) + 1]++;
+
+    // turn the counts into where each cell starts
+    for (int i = 0; i < cellCount; i++)
+        grid->CellStart[i + 1] += grid->CellStart[i];
+
+    // put each player into its cell, filling each cell from the back using the start of the next cell as a write cursor
+    for (int i = 0; i < grid->Count; i++)
+    {
+        int cell = GetCellIndex(grid, grid->Pending[i].X, grid->Pending[i].Y);
+        grid->Entries[--grid->CellStart[cell + 1]] = grid->Pending[i];
+    }
+
+    // each cursor has been moved back to the start of the cell before it, so shift them down to line up with their cell
+    for (int i = 0; i < cellCount; i++)
+        grid->CellStart[i] = grid->CellStart[i + 1];
+
+    // the last cell ends at the end of the entries
+    grid->CellStart[cellCount] = grid->Count;
+}
+
+int InterestGridQuery(const InterestGrid* grid, int16_t x, int16_t y, int radius, int* results, int maxResults)
+{
+    int found = 0;
+    int64_t radiusSquared = (int64_t)radius * radius;
+
+    // find the range of cells that the radius touches
+    int minColumn = (x - radius) / grid->CellSize;
+    int maxColumn = (x + radius) / grid->CellSize;
+    int minRow = (y - radius) / grid->CellSize;
+    int maxRow = (y + radius) / grid->CellSize;
+
+    if (minColumn < 0)
+        minColumn = 0;
+    if (maxColumn >= grid->Columns)
+        maxColumn = grid->Columns - 1;
+    if (minRow < 0)
+        minRow = 0;
+    if (maxRow >= grid->Rows)
+        maxRow = grid->Rows - 1;
+
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int column = minColumn; column <= maxColumn; column++)
+        {
+            int cell = row * grid->Columns + column;
+
+            for (int i = grid->CellStart[cell]; i < grid->CellStart[cell + 1]; i++)
+            {
+                const InterestEntry* entry = &grid->Entries[i];
+                int dx = entry->X - x;
+                int dy = entry->Y - y;
+
+                if ((int64_t)dx * dx + (int64_t)dy * dy > radiusSquared)
+                    continue;
+
+                if (found == maxResults)
+                    return found;
+
+                results[found++] = entry->Id;
+            }
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,85 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Area of interest grid for the server
+// The field is split up into square cells, and every player with a position is put in the cell they are in.
+// To find who is near a player, only the cells around them need to be checked, not every player in the game.
+// This keeps the cost of deciding who to send updates to based on how crowded an area is, not how many players there are.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// one player in the grid
+typedef struct
+{
+    int Id;
+    int16_t X;
+    int16_t Y;
+}InterestEntry;
+
+// the grid itself, it is rebuilt from scratch every tick
+typedef struct
+{
+    // how big each cell is, and how many there are across and down the field
+    int CellSize;
+    int Columns;
+    int Rows;
+
+    // the most players the grid can hold
+    int Capacity;
+
+    // players added since the last build, in the order they were added
+    int Count;
+    InterestEntry* Pending;
+
+    // for each cell, where its players start in Entries. Has one extra item at the end so the last cell knows where it ends
+    int* CellStart;
+
+    // all the players sorted by cell
+    InterestEntry* Entries;
+}InterestGrid;
+
+// setup a grid that covers a field of the given size, returns false if memory could not be allocated
+bool InterestGridInit(InterestGrid* grid, int fieldWidth, int fieldHeight, int cellSize, int capacity);
+
+// release the memory used by a grid
+void InterestGridFree(InterestGrid* grid);
+
+// remove all players from the grid, call this before adding the players for a new tick
+void InterestGridClear(InterestGrid* grid);
+
+// add a player to the grid at a location, call InterestGridBuild when all players are added
+void InterestGridAdd(InterestGrid* grid, int id, int16_t x, int16_t y);
+
+// sort the added players into their cells, this must be done before the grid can be queried
+void InterestGridBuild(InterestGrid* grid);
+
+// find all the players within radius of a location
+// fills out the ids of the players found (up to maxResults) and returns how many were found
+int InterestGridQuery(const InterestGrid* grid, int16_t x, int16_t y, int radius, int* results, int maxResults);
@@ -0,0 +1,119 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the lag compensation history
+
+#include "lag_history.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool LagHistoryInit(LagHistory* history, int capacity, int length)
+{
+    memset(history, 0, sizeof(LagHistory));
+
+    if (length < 1)
+        length = 1;
+
+    history->Capacity = capacity;
+    history->Length = length;
+
+    size_t count = (size_t)capacity * length;
+    history->Ticks = (uint32_t*)calloc(length, sizeof(uint32_t));
+    history->X = (int16_t*)calloc(count, sizeof(int16_t));
+    history->Y = (int16_t*)calloc(count, sizeof(int16_t));
+    history->Valid = (uint8_t*)calloc(count, sizeof(uint8_t));
+
+    if (history->Ticks == NULL || history->X == NULL || history->Y == NULL || history->Valid == NULL)
+    {
+        LagHistoryFree(history);
+        return false;
+    }
+
+    return true;
+}
+
+void LagHistoryFree(LagHistory* history)
+{
+    free(history->Ticks);
+    free(history->X);
+    free(history->Y);
+    free(history->Valid);
+    memset(history, 0, sizeof(LagHistory));
+}
+
+// find where a tick's players start, or -1 if the tick is not kept
+static int64_t GetTickOffset(const LagHistory* history, uint32_t tick)
+{
+    int slot = (int)(tick % (uint32_t)history->Length);
+    if (tick == 0 || history->Ticks[slot] != tick)
+        return -1;
+
+    return (int64_t)slot * history->Capacity;
+}
+
+void LagHistoryRecord(LagHistory* history, uint32_t tick, const int16_t* x, const int16_t* y, const uint64_t* live)
+{
+    int slot = (int)(tick % (uint32_t)history->Length);
+    size_t offset = (size_t)slot * history->Capacity;
+    history->Ticks[slot] = tick;
+
+    memcpy(history->X + offset, x, sizeof(int16_t) * history->Capacity);
+    memcpy(history->Y + offset, y, sizeof(int16_t) * history->Capacity);
+
+    // one byte per player is quicker to check in queries than picking out bits
+    uint8_t* valid = history->Valid + offset;
+    for (int i = 0; i < history->Capacity; i++)
+        valid[i] = (uint8_t)((live[i / 64] >> (i % 64)) & 1);
+}
+
+int LagHistoryQuery(const LagHistory* history, uint32_t tick, int16_t x, int16_t y, int radius, int* results, int maxResults)
+{
+    int64_t offset = GetTickOffset(history, tick);
+    if (offset < 0)
+        return -1;
+
+    const int16_t* xs = history->X + offset;
+    const int16_t* ys = history->Y + offset;
+    const uint8_t* valid = history->Valid + offset;
+    int64_t radiusSquared = (int64_t)radius * radius;
+
+    // go through every player in the tick, this is just a few reads and multiplies for each one
+    // and it reads straight through the arrays, so it stays fast even with thousands of players
+    int count = 0;
+    for (int i = 0; i < history->Capacity && count < maxResults; i++)
+    {
+        int dx = xs[i] - x;
+        int dy = ys[i] - y;
+
+        if (valid[i] && (int64_t)dx * dx + (int64_t)dy * dy <= radiusSquared)
+            results[count++] = i;
+    }
+
+    return count;
+}
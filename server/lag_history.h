@@ -0,0 +1,71 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Lag compensation history for the server
+// Clients see other players a little in the past, because updates take time to get to them and they draw between two updates.
+// To check something the way a client saw it (did they touch another player, were they close enough to pick something up)
+// the server needs to know where everyone was at that time, not where they are now.
+// This keeps the position of every player for the last few ticks, so checks can be done at any tick that is still kept.
+// Each tick is stored as separate arrays of X, Y and valid flags (structure of arrays), so a query over every player
+// only reads the data it needs, one tick after the other. Everything is allocated once up front, recording and queries never allocate.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// the history itself, a ring of ticks indexed by tick % Length
+typedef struct
+{
+    // the most players in a tick
+    int Capacity;
+
+    // how many ticks are kept
+    int Length;
+
+    // the tick stored in each slot, 0 if the slot is empty
+    uint32_t* Ticks;
+
+    // the players for every slot, Length * Capacity items, with one slot's players after the other
+    int16_t* X;
+    int16_t* Y;
+    uint8_t* Valid;
+}LagHistory;
+
+// setup a history for up to capacity players that keeps length ticks, returns false if memory could not be allocated
+bool LagHistoryInit(LagHistory* history, int capacity, int length);
+
+// release the memory used by a history
+void LagHistoryFree(LagHistory* history);
+
+// record where every player is for a new tick, this replaces the oldest tick
+// the positions are copied straight from the arrays, and live has one bit for each player that is in the game
+void LagHistoryRecord(LagHistory* history, uint32_t tick, const int16_t* x, const int16_t* y, const uint64_t* live);
+
+// find all the players that were within radius of a location at a tick
+// fills out the ids of the players found (up to maxResults) and returns how many were found, or -1 if the tick is no longer kept
+int LagHistoryQuery(const LagHistory* history, uint32_t tick, int16_t x, int16_t y, int radius, int* results, int maxResults);
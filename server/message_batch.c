@@ -0,0 +1,105 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of message batching
+
+// ensure we are using winsock2 on windows.
+#if (_WIN32_WINNT < 0x0601)
+	#undef _WIN32_WINNT
+    #define _WIN32_WINNT 0x0601
+#endif
+
+#include "message_batch.h"
+#include "threading.h"
+
+// how many batches were thrown away because they did not fit in their packet, from any thread
+static volatile uint32_t DroppedBatches = 0;
+
+void MessageBatchInit(MessageBatch* batch, ENetPeer* peer, enet_uint8 channel, enet_uint32 flags, size_t maxSize, MessageSendFunction send)
+{
+    batch->Peer = peer;
+    batch->Channel = channel;
+    batch->Flags = flags;
+    batch->Send = send;
+    batch->MaxSize = maxSize;
+    batch->Writer.Packet = NULL;
+}
+
+PacketWriter* MessageBatchBegin(MessageBatch* batch, size_t messageSize)
+{
+    // it won't fit with what is already waiting, so send that first
+    // a message starts on a whole byte, so a byte that is only partly filled with bits counts as used
+    if (batch->Writer.Packet != NULL && batch->Writer.Offset + (batch->Writer.BitCount > 0 ? 1 : 0) + messageSize > batch->MaxSize)
+        MessageBatchFlush(batch);
+
+    if (batch->Writer.Packet == NULL)
+    {
+        size_t capacity = messageSize > batch->MaxSize ? messageSize : batch->MaxSize;
+        if (!PacketWriterBegin(&batch->Writer, capacity, batch->Flags))
+            return NULL;
+    }
+
+    return &batch->Writer;
+}
+
+void MessageBatchFlush(MessageBatch* batch)
+{
+    if (batch->Writer.Packet == NULL)
+        return;
+
+    if (batch->Writer.Offset == 0 && batch->Writer.BitCount == 0)
+    {
+        PacketWriterDiscard(&batch->Writer);
+        return;
+    }
+
+    // NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
+    // you don't have to destroy them
+    // this only fails if the messages ran past the end of the packet, and then every message in it is lost
+    ENetPacket* packet = PacketWriterEnd(&batch->Writer);
+    if (packet == NULL)
+    {
+        AtomicAdd(&DroppedBatches, 1);
+        return;
+    }
+
+    if (batch->Send != NULL)
+        batch->Send(batch->Peer, batch->Channel, packet);
+    else
+        enet_peer_send(batch->Peer, batch->Channel, packet);
+}
+
+void MessageBatchDiscard(MessageBatch* batch)
+{
+    PacketWriterDiscard(&batch->Writer);
+}
+
+uint32_t MessageBatchGetDropped()
+{
+    return AtomicLoad(&DroppedBatches);
+}
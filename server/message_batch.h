@@ -0,0 +1,82 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Batches messages to a player into as few packets as possible
+// Every enet packet costs a command header (and an acknowledgement if it is reliable) and an allocation,
+// which is a lot for messages that are only a few bytes long.
+// Messages are written into one packet until it is as big as will fit in one datagram, then a new packet is started.
+// Nothing is sent until the batch is flushed, which the server does once per tick.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "packet_io.h"
+
+// how many bytes of a datagram enet uses for its own headers
+// this is the protocol header, the checksum and the biggest send command header, with room to spare
+#define BATCH_HEADER_OVERHEAD 32
+
+// sends a finished packet, for when packets are not sent with enet_peer_send right away
+typedef void (*MessageSendFunction)(ENetPeer* peer, enet_uint8 channel, ENetPacket* packet);
+
+// the messages waiting to go to one player on one channel
+typedef struct
+{
+    ENetPeer* Peer;
+    enet_uint8 Channel;
+    enet_uint32 Flags;
+
+    // what sends the packets, NULL to use enet_peer_send
+    MessageSendFunction Send;
+
+    // the biggest packet we build, so that a packet fits in one datagram
+    size_t MaxSize;
+
+    // the packet being filled, Writer.Packet is NULL when nothing is waiting
+    PacketWriter Writer;
+}MessageBatch;
+
+// setup a batch for a player, nothing is allocated until a message is added
+// packets are sent with the send function, or with enet_peer_send if it is NULL
+void MessageBatchInit(MessageBatch* batch, ENetPeer* peer, enet_uint8 channel, enet_uint32 flags, size_t maxSize, MessageSendFunction send);
+
+// make room for a message of up to messageSize bytes, sending what is waiting if the message won't fit with it
+// returns the writer to write the message with, or NULL if a packet could not be allocated
+// messages bigger than the max size get a packet of their own, and enet will split it up
+PacketWriter* MessageBatchBegin(MessageBatch* batch, size_t messageSize);
+
+// send all the messages that are waiting
+void MessageBatchFlush(MessageBatch* batch);
+
+// throw away all the messages that are waiting, used when the player is gone
+void MessageBatchDiscard(MessageBatch* batch);
+
+// how many batches have been thrown away since the server started, because their messages ran past the end of the packet
+uint32_t MessageBatchGetDropped();
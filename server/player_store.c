@@ -0,0 +1,159 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the player storage
+// the loops in here are kept free of branches and function calls, so the compiler can vectorize them
+
+#include "player_store.h"
+
+// the field bits for world updates
+#include "protocol.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// older versions of visual studio only know restrict by its own name
+#if defined(_MSC_VER)
+#define restrict __restrict
+#endif
+
+bool PlayerStoreInit(PlayerStore* store, int capacity)
+{
+    memset(store, 0, sizeof(PlayerStore));
+
+    capacity = (capacity + PLAYER_STORE_BLOCK - 1) / PLAYER_STORE_BLOCK * PLAYER_STORE_BLOCK;
+    if (capacity < PLAYER_STORE_BLOCK)
+        capacity = PLAYER_STORE_BLOCK;
+
+    store->Capacity = capacity;
+    store->X = (int16_t*)calloc(capacity, sizeof(int16_t));
+    store->Y = (int16_t*)calloc(capacity, sizeof(int16_t));
+    store->DX = (int16_t*)calloc(capacity, sizeof(int16_t));
+    store->DY = (int16_t*)calloc(capacity, sizeof(int16_t));
+    store->Live = (uint64_t*)calloc(capacity / 64, sizeof(uint64_t));
+
+    if (store->X == NULL || store->Y == NULL || store->DX == NULL || store->DY == NULL || store->Live == NULL)
+    {
+        PlayerStoreFree(store);
+        return false;
+    }
+
+    return true;
+}
+
+void PlayerStoreFree(PlayerStore* store)
+{
+    free(store->X);
+    free(store->Y);
+    free(store->DX);
+    free(store->DY);
+    free(store->Live);
+    memset(store, 0, sizeof(PlayerStore));
+}
+
+void PlayerStoreCopy(PlayerStore* destination, const PlayerStore* source)
+{
+    size_t size = sizeof(int16_t) * source->Capacity;
+    memcpy(destination->X, source->X, size);
+    memcpy(destination->Y, source->Y, size);
+    memcpy(destination->DX, source->DX, size);
+    memcpy(destination->DY, source->DY, size);
+    memcpy(destination->Live, source->Live, sizeof(uint64_t) * (source->Capacity / 64));
+}
+
+// move one axis of every player, rounding to the nearest pixel the same way MoveAxis does
+static void IntegrateAxis(int16_t* restrict position, const int16_t* restrict speed, int count, int durationMs)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int distance = speed[i] * durationMs;
+        position[i] = (int16_t)(position[i] + (distance + (distance < 0 ? -500 : 500)) / 1000);
+    }
+}
+
+void PlayerStoreIntegrate(PlayerStore* store, int durationMs)
+{
+    IntegrateAxis(store->X, store->DX, store->Capacity, durationMs);
+    IntegrateAxis(store->Y, store->DY, store->Capacity, durationMs);
+}
+
+// keep one axis of every player between 0 and a limit
+static void ClampAxis(int16_t* restrict position, int count, int16_t limit)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int16_t value = position[i] < 0 ? 0 : position[i];
+        position[i] = value > limit ? limit : value;
+    }
+}
+
+void PlayerStoreClamp(PlayerStore* store, int16_t maxX, int16_t maxY)
+{
+    ClampAxis(store->X, store->Capacity, maxX);
+    ClampAxis(store->Y, store->Capacity, maxY);
+}
+
+void PlayerStoreDiff(const PlayerStore* current, const PlayerStore* base, uint8_t* restrict masks)
+{
+    const int16_t* restrict x = current->X;
+    const int16_t* restrict y = current->Y;
+    const int16_t* restrict dx = current->DX;
+    const int16_t* restrict dy = current->DY;
+    const int16_t* restrict oldX = base->X;
+    const int16_t* restrict oldY = base->Y;
+    const int16_t* restrict oldDX = base->DX;
+    const int16_t* restrict oldDY = base->DY;
+
+    for (int i = 0; i < current->Capacity; i++)
+    {
+        masks[i] = (uint8_t)((x[i] != oldX[i] ? FIELD_X : 0) |
+                             (y[i] != oldY[i] ? FIELD_Y : 0) |
+                             ((dx[i] != oldDX[i]) | (dy[i] != oldDY[i]) ? FIELD_DIR : 0));
+    }
+}
+
+int PlayerStoreNextLive(const PlayerStore* store, int after)
+{
+    int id = after + 1;
+    if (id >= store->Capacity)
+        return -1;
+
+    // skip the bits before the id in its word, then go a word at a time
+    int word = id / 64;
+    uint64_t bits = store->Live[word] & (~0ull << (id % 64));
+
+    while (bits == 0)
+    {
+        if (++word >= store->Capacity / 64)
+            return -1;
+
+        bits = store->Live[word];
+    }
+
+    return word * 64 + LowestBit(bits);
+}
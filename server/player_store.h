@@ -0,0 +1,119 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// Player storage for the server
+// The state of every player that is sent to clients is kept as separate arrays (structure of arrays) instead of one struct per player.
+// Passes over the whole world, like moving everyone or working out what changed since an old world update,
+// only read the arrays they need, one after the other, and are simple enough loops that the compiler turns them into SIMD code.
+// The same storage is used for the live world and for each world update in the history, so saving a world update is just a few copies.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// storage is rounded up to a multiple of this many players, so the live mask is whole words and loops don't need a tail
+#define PLAYER_STORE_BLOCK 64
+
+// the state of every player
+typedef struct
+{
+    // how many players there is room for, this is a multiple of PLAYER_STORE_BLOCK
+    int Capacity;
+
+    // the position and direction of each player
+    int16_t* X;
+    int16_t* Y;
+    int16_t* DX;
+    int16_t* DY;
+
+    // one bit for each player that is in the game and has a position, Capacity / 64 words
+    uint64_t* Live;
+}PlayerStore;
+
+// setup storage for at least capacity players, everything starts at 0 and nobody is live
+// returns false if memory could not be allocated
+bool PlayerStoreInit(PlayerStore* store, int capacity);
+
+// release the memory used by a store
+void PlayerStoreFree(PlayerStore* store);
+
+// copy everything from one store to another with the same capacity
+void PlayerStoreCopy(PlayerStore* destination, const PlayerStore* source);
+
+// move every player along their direction for a number of milliseconds, the same way MoveAxis does
+// this does not keep them in the field, use PlayerStoreClamp after it
+void PlayerStoreIntegrate(PlayerStore* store, int durationMs);
+
+// keep every player inside the field
+void PlayerStoreClamp(PlayerStore* store, int16_t maxX, int16_t maxY);
+
+// work out what fields of every player are different between two stores, as the FIELD_ bits used in world updates
+// masks must have room for Capacity items
+void PlayerStoreDiff(const PlayerStore* current, const PlayerStore* base, uint8_t* masks);
+
+// find the next live player after an id, pass -1 to get the first one
+// returns -1 when there are no more
+int PlayerStoreNextLive(const PlayerStore* store, int after);
+
+// is a player in the game with a position
+static inline bool PlayerStoreIsLive(const PlayerStore* store, int id)
+{
+    return (store->Live[id / 64] >> (id % 64)) & 1;
+}
+
+// set if a player is in the game with a position
+static inline void PlayerStoreSetLive(PlayerStore* store, int id, bool live)
+{
+    if (live)
+        store->Live[id / 64] |= 1ull << (id % 64);
+    else
+        store->Live[id / 64] &= ~(1ull << (id % 64));
+}
+
+// the index of the lowest bit that is set, bits must not be 0
+static inline int LowestBit(uint64_t bits)
+{
+#if defined(_MSC_VER) && defined(_M_IX86)
+    // 32 bit windows has no 64 bit scan, so look in the low half and then the high half
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)bits))
+        return (int)index;
+    _BitScanForward(&index, (unsigned long)(bits >> 32));
+    return (int)index + 32;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
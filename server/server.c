@@ -28,360 +28,1576 @@
 
 // server code
 
-// ensure we are using winsock2 on windows.
 // ensure we are using winsock2 on windows.
 #if (_WIN32_WINNT < 0x0601)
 	#undef _WIN32_WINNT
     #define _WIN32_WINNT 0x0601
 #endif
 
+// let enet use the socket calls that are only on linux, like recvmmsg to read many datagrams at once
+// this has to come before any system header
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE
+#endif
+
 // include the network layer from enet (https://github.com/zpl-c/enet)
 #define ENET_IMPLEMENTATION
 #include "enet.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-// max number of players
-#define MAX_CLIENTS 8
+// the protocol and packet functions shared with the client
+#include "protocol.h"
+#include "packet_io.h"
 
-// All the different commands that can be sent over the network
-typedef enum
-{
-    // Server -> Client, You have been accepted. Contains the id for the client player to use
-    AcceptPlayer = 1,
+#include "interest.h"
+#include "message_batch.h"
+#include "lag_history.h"
+#include "player_store.h"
+#include "worker_pool.h"
+#include "host_waiter.h"
+
+// the network thread and the queues it talks to the simulation with
+#include "threading.h"
+#include "spsc_queue.h"
+
+// how many players the server allows by default, this can be changed on the command line after the view radius
+#define DEFAULT_MAX_CLIENTS 64
+
+// how many times a second the server simulates the game and sends out world updates
+// this can be changed by passing a different rate on the command line
+#define DEFAULT_TICK_RATE 20
+
+// the largest tick rate we allow, anything faster just burns CPU and bandwidth
+#define MAX_TICK_RATE 120
+
+// how far away (in pixels) a player can see other players, players further than this are not sent to them
+// this can be changed by passing a different radius on the command line after the tick rate
+#define DEFAULT_VIEW_RADIUS 400
+
+// a radius that reaches from one corner of the field to the other already sees everyone, so bigger ones are cut down to this
+#define MAX_VIEW_RADIUS (FieldSizeWidth + FieldSizeHeight)
+
+// how often (in seconds) the server prints how it is doing
+#define STATUS_INTERVAL 60
+
+// how many seconds of player positions are kept for lag compensation
+#define LAG_HISTORY_SECONDS 1
+
+// where new players start on the field
+#define SPAWN_X 100
+#define SPAWN_Y 100
+
+// how many threads build world updates along with the main thread, this can be changed on the command line after the movement mode
+// when this is more than 0 the network also gets its own thread, passing 0 runs the whole server on one thread
+#define DEFAULT_WORKER_THREADS 2
+
+// how many hosts share the server port, each with its own network thread, this can be changed on the command line after the worker threads
+// more than 1 needs SO_REUSEPORT, where the system spreads the clients between the hosts
+#define DEFAULT_SHARD_COUNT 1
+
+// the longest (in milliseconds) a network thread sleeps without servicing its host, so enet resends lost packets and pings on time
+// it is woken up as soon as a packet comes in or another thread has packets for it to send
+#define NETWORK_SERVICE_INTERVAL 5
 
-    // Server -> Client, Add a new player to your simulation, contains the ID of the player and a position
-    AddPlayer = 2,
+// when true, the hosts do their socket reads and writes through io_uring instead of a system call for each datagram
+// this can be turned on by passing 1 on the command line after the shard count, it is only on Linux
+#define DEFAULT_USE_IO_URING false
 
-    // Server -> Client, Remove a player from your simulation, contains the ID of the player to remove
-    RemovePlayer = 3,
+// how long (in milliseconds) a network thread waits for the simulation to make room in its inbound queue
+#define NETWORK_THREAD_INTERVAL 1
 
-    // Server -> Client, Update a player's position in the simulation, contains the ID of the player and a position
-    UpdatePlayer = 4,
+// the most events each player can send the simulation in a tick before the network thread has to wait for it
+#define INBOUND_EVENTS_PER_PLAYER 8
 
-    // Client -> Server, Provide an updated location for the client's player, contains the postion to update
-    UpdateInput = 5,
-}NetworkCommands;
+// how many packets each thread can have waiting for the network thread to send
+#define OUTBOUND_QUEUE_SIZE 4096
 
+// the most input time (in milliseconds) a player can save up
+// clients get this much time to move every tick, so a client can't move faster than real time, but a late packet can catch up
+#define MAX_MOVE_TIME_BANK 1000
 
-// the info we are tracking about each player in the game
+// another player that a player can see
+typedef struct
+{
+    int Id;
+
+    // the first world update that this player was part of for the player that sees them
+    // updates from before this don't have them in it, so they can't be used as a base
+    uint32_t Since;
+}VisiblePlayer;
+
+// the info we are tracking about each player's connection
+// where they are and where they are going is in World, so that passes over every player don't have to load all of this
 typedef struct
 {
     // is this player slot active
     bool Active;
 
-    // have they sent us a valid position yet?
-    bool ValidPosition;
-
-    // the network connection they use
+    // the network connection they use, and the id enet gave the connection
+    // the network thread checks the id before sending, so nothing meant for this player goes to someone that reused the peer
     ENetPeer* Peer;
+    enet_uint32 ConnectId;
+
+    // the last world update this player told us they got, 0 if they have not gotten one yet
+    uint32_t AckedTick;
+
+    // when the server is authoritative, the sequence number of the last input we processed for this player
+    // and if we have processed any since the last correction we sent them
+    uint16_t LastInput;
+    bool NeedsCorrection;
+
+    // how much time (in milliseconds) this player has left to move, see MAX_MOVE_TIME_BANK
+    int MoveTimeBank;
 
-    // the last known location in X and Y
-    int16_t X;
-    int16_t Y;
+    // reliable messages waiting to go to this player, they are sent all at once at the end of the tick
+    MessageBatch Reliable;
 
-    int16_t DX;
-    int16_t DY;
+    // the other players that are close enough for this player to know about
+    // this list grows as needed, so crowded areas don't cost memory for everyone
+    int VisibleCount;
+    int VisibleCapacity;
+    VisiblePlayer* Visible;
 }PlayerInfo;
 
+// a copy of the world at one tick, kept so we can send clients only what changed since the last one they got
+typedef struct
+{
+    uint32_t Tick;
+    PlayerStore Players;
+}WorldState;
+
+// an event the network thread got from enet, for the simulation to handle
+typedef struct
+{
+    ENetEventType Type;
+    ENetPeer* Peer;
+    enet_uint32 ConnectId;
+    ENetPacket* Packet;
+}InboundEvent;
 
-// The list of all possible players
+// a packet for the network thread to send, a NULL packet means disconnect the peer
+typedef struct
+{
+    ENetPeer* Peer;
+    enet_uint32 ConnectId;
+    enet_uint8 Channel;
+    ENetPacket* Packet;
+}OutboundPacket;
+
+// one host bound to the server port and the thread that looks after it
+// each player belongs to the shard the system gave their first packet to, and stays there
+typedef struct
+{
+    ENetHost* Host;
+    Thread Thread;
+    bool Started;
+
+    // what the thread sleeps on, other threads wake it when they give it packets to send
+    HostWaiter Waiter;
+    bool HasWaiter;
+
+    // events for the simulation, and packets from each worker to send, 0 is the main thread
+    SpscQueue InboundQueue;
+    SpscQueue* OutboundQueues;
+
+    // the host's command pool counters, only the thread that owns the host can read them, so it copies them here for the status print
+    volatile uint64_t CommandPoolHits;
+    volatile uint64_t CommandPoolMisses;
+}NetworkShard;
+
+// a tick and the server clock when it was supposed to run
+typedef struct
+{
+    uint32_t Tick;
+    enet_uint32 Time;
+}TickClock;
+
+
+// how many players this server allows
+int MaxClients = DEFAULT_MAX_CLIENTS;
+
+// the threads that help build world updates
+int WorkerThreads = DEFAULT_WORKER_THREADS;
+WorkerPool Workers = { 0 };
+
+// the server hosts, there is always at least one
+// all of them feed the same simulation, so every player sees everyone no matter what shard they are on
+int ShardCount = DEFAULT_SHARD_COUNT;
+NetworkShard* Shards = NULL;
+bool UseIoUring = DEFAULT_USE_IO_URING;
+
+// true if the network has its own threads
+// then each network thread is the only one that touches its host and peers,
+// the simulation gets events from it through its inbound queue and every thread gives it packets to send through its own outbound queue
+bool Pipelined = false;
+volatile uint32_t NetworkRunning = 0;
+
+// which worker this thread is, so it knows what outbound queue to use
+THREAD_LOCAL int CurrentWorker = 0;
+
+// the connection id of the peer the event being handled came from
+enet_uint32 CurrentConnectId = 0;
+
+// the current tick and when it ran, for the network thread to answer time requests with
+// both are packed into one 64 bit value and stored at once, so a reader can never see the tick from one update with the time from another
+volatile uint64_t PublishedClock = 0;
+
+// when true, the server moves players from the inputs they send, instead of taking the position they say they are at
+// this can be turned off by passing 0 on the command line after the max players
+bool AuthoritativeMovement = true;
+
+// how long a tick is in milliseconds
+int TickInterval = 1000 / DEFAULT_TICK_RATE;
+
+// the server clock (enet_time_get) when the current tick was supposed to run
+// ticks run on a fixed schedule, so clients can work out the tick at any time from this
+enet_uint32 CurrentTickTime = 0;
+
+// The list of all possible players, this has MaxClients items in it
+// this is the connection info for each player
+PlayerInfo* Players = NULL;
+
+// where every player is and where they are going
 // this is the server state of the game that represents the current game state
 // this is what server code would check to see where all the players are and what they are doing
-PlayerInfo Players[MAX_CLIENTS] = { 0 };
+// a player is live in here once they are active and have given us a position
+PlayerStore World = { 0 };
+
+// the slots that nobody is using, new players take the one on the top of the stack
+int* FreeSlots = NULL;
+int FreeSlotCount = 0;
 
-// Utility functions to read data out of a packet
-// Optimally this would go into a library that was shared by the client and the server
+// the recent history of world states, indexed by tick % SNAPSHOT_HISTORY
+// each one has room for MaxClients players
+WorldState History[SNAPSHOT_HISTORY] = { 0 };
 
-/// <summary>
-/// Read one byte out of a packet, from an offset, and update that offset to the next location to read from
-/// </summary>
-/// <param name="packet">The packet to read from</param>
-/// <param name="offset">A pointer to an offset that is updated, this should be passed to other read functions so they read from the correct place</param>
-/// <returns>The byte read</returns>
-uint8_t ReadByte(ENetPacket* packet, size_t* offset)
+// what changed for every player between the current world and an older one, indexed by how old the older one is
+// clients that got the same world update share the same base, so this is worked out once for all of them the first time it is needed
+uint8_t* ChangeMasks[SNAPSHOT_HISTORY] = { 0 };
+uint32_t ChangeMaskTick[SNAPSHOT_HISTORY] = { 0 };
+
+// the tick of the last world update, tick 0 is never sent so it can mean 'no update'
+uint32_t CurrentTick = 0;
+
+// the biggest packet we send, so that every packet fits in one datagram
+size_t MaxBatchSize = ENET_HOST_DEFAULT_MTU - BATCH_HEADER_OVERHEAD;
+
+// where every player was for the last LAG_HISTORY_SECONDS, so checks can be done as a client saw the world
+LagHistory Rewind = { 0 };
+
+// how far players can see, and the grid used to find who is near who
+int ViewRadius = DEFAULT_VIEW_RADIUS;
+InterestGrid Grid = { 0 };
+
+// scratch data used when working out who can see who
+// a player's mark is set to the current stamp when they are found, so we don't have to clear anything between players
+// these all have MaxClients items in them
+uint32_t InterestStamp = 0;
+uint32_t* InterestMark = NULL;
+int* InterestIndex = NULL;
+int* NearbyPlayers = NULL;
+VisiblePlayer* VisibleScratch = NULL;
+
+// finds the player slot that goes with the player connection
+// when a player is accepted we store a pointer to their slot in the peer's application data (ENetPeer::data)
+// so this is just a lookup, and does not need to search the player list for every packet
+int GetPlayerId(ENetPeer* peer)
 {
-    // make sure we have not gone past the end of the data we were sent
-    if (*offset > packet->dataLength)
-        return 0;
+    PlayerInfo* player = (PlayerInfo*)enet_peer_get_data(peer);
+    if (player == NULL || !player->Active)
+        return -1;
+
+    return (int)(player - Players);
+}
 
-    // cast the data to a byte so we can increment it in 1 byte chunks
-    uint8_t* ptr = (uint8_t*)packet->data;
+// finds the shard whose host a peer belongs to
+NetworkShard* GetShard(ENetPeer* peer)
+{
+    for (int i = 1; i < ShardCount; i++)
+    {
+        if (Shards[i].Host == peer->host)
+            return &Shards[i];
+    }
 
-    // get the byte at the current offset
-    uint8_t data = ptr[(*offset)];
+    return &Shards[0];
+}
 
-    // move the offset over 1 byte for the next read
-    *offset = *offset + 1;
+// give a message to the network thread that looks after a peer, through this thread's queue
+void PushOutbound(ENetPeer* peer, OutboundPacket* message)
+{
+    NetworkShard* shard = GetShard(peer);
 
-    return data;
+    // the network thread is behind, make sure it is awake and give it a moment to catch up
+    while (!SpscQueuePush(&shard->OutboundQueues[CurrentWorker], message))
+    {
+        HostWaiterWake(&shard->Waiter);
+        ThreadSleep(1);
+    }
 }
 
-/// <summary>
-/// Read a signed short from the network packet
-/// Note that this assumes the packet is in the host's byte ordering
-/// In reality read/write code should use ntohs and htons to convert from network byte order to host byte order, so both big endian and little endian machines can play together
-/// </summary>
-/// <param name="packet">The packet to read from<</param>
-/// <param name="offset">A pointer to an offset that is updated, this should be passed to other read functions so they read from the correct place</param>
-/// <returns>The signed short that is read</returns>
-int16_t ReadShort(ENetPacket* packet, size_t* offset)
+// send a packet to a player
+// with network threads this goes into this thread's outbound queue for the player's shard, and the network thread sends it
+void SendPacket(ENetPeer* peer, enet_uint8 channel, ENetPacket* packet)
 {
-    // make sure we have not gone past the end of the data we were sent
-    if (*offset > packet->dataLength)
-        return 0;
+    if (!Pipelined)
+    {
+        enet_peer_send(peer, channel, packet);
+        return;
+    }
 
-    // cast the data to a byte at the offset
-    uint8_t* data = (uint8_t*)packet->data;
-    data += (*offset);
+    PlayerInfo* player = (PlayerInfo*)enet_peer_get_data(peer);
+    OutboundPacket message = { peer, player != NULL ? player->ConnectId : 0, channel, packet };
+    PushOutbound(peer, &message);
+}
 
-    // move the offset over 2 bytes for the next read
-    *offset = (*offset) + 2;
+// disconnect a peer that sent the event being handled
+void DisconnectPeer(ENetPeer* peer)
+{
+    if (!Pipelined)
+    {
+        enet_peer_disconnect(peer, 0);
+        return;
+    }
 
-    // cast the data pointer to a short and return a copy
-    return *(int16_t*)data;
+    OutboundPacket message = { peer, CurrentConnectId, 0, NULL };
+    PushOutbound(peer, &message);
 }
 
-// finds the player slot that goes with the player connection
-// the peer has the void* ENetPeer::data that can be used to store arbitary application data
-// but that involves managing structure pointers so it is kept out of this example
-int GetPlayerId(ENetPeer* peer)
+// get the tick and when it ran, this can be called from any thread
+TickClock GetPublishedClock()
+{
+    uint64_t packed = AtomicLoad64(&PublishedClock);
+
+    TickClock clock;
+    clock.Tick = (uint32_t)(packed >> 32);
+    clock.Time = (enet_uint32)packed;
+    return clock;
+}
+
+// make the current tick the one that time requests are answered with
+void PublishClock()
+{
+    AtomicStore64(&PublishedClock, ((uint64_t)CurrentTick << 32) | CurrentTickTime);
+}
+
+
+// tell one player to add another player to their simulation
+// this is added to the player's reliable batch, and goes out with everything else at the end of the tick
+void SendAddPlayer(PlayerInfo* recipient, int playerId)
+{
+    // pack up an add player message with the ID and the last known position
+    // this goes on a different channel than world updates, so it has the tick it was sent on
+    // that way the client can tell if a world update that shows up after it is older than it is
+    // the position and direction are bit packed into 4 bytes
+    PacketWriter* writer = MessageBatchBegin(&recipient->Reliable, 11);
+    if (writer == NULL)
+        return;
+
+    WriteByte(writer, (uint8_t)AddPlayer);
+    WriteUShort(writer, (uint16_t)playerId);
+    WriteInt(writer, CurrentTick);
+    WriteBits(writer, World.X[playerId], POSITION_X_BITS);
+    WriteBits(writer, World.Y[playerId], POSITION_Y_BITS);
+    WriteBits(writer, EncodeDirection(World.DX[playerId], World.DY[playerId]), DIRECTION_BITS);
+
+    // Optimally we'd also send other info like name, color, and other static player info.
+}
+
+// tell one player to remove another player from their simulation
+void SendRemovePlayer(PlayerInfo* recipient, int playerId)
+{
+    PacketWriter* writer = MessageBatchBegin(&recipient->Reliable, 7);
+    if (writer == NULL)
+        return;
+
+    WriteByte(writer, (uint8_t)RemovePlayer);
+    WriteUShort(writer, (uint16_t)playerId);
+    WriteInt(writer, CurrentTick);
+}
+
+// write what the server clock says now, and when the current tick ran, so the client can line its clock up with ours
+// this is called by the network thread too, so it uses the published tick
+void WriteServerClock(PacketWriter* writer)
+{
+    TickClock clock = GetPublishedClock();
+    WriteInt(writer, enet_time_get());
+    WriteInt(writer, clock.Tick);
+    WriteInt(writer, clock.Time);
+}
+
+// a new client is trying to connect
+void HandleConnect(ENetPeer* peer)
 {
-    // find the slot that matches the pointer
-    for (int i = 0; i < MAX_CLIENTS; i++)
+    printf("Player Connected\n");
+
+    // enet does not clear the application data when a peer is reused, so make sure it doesn't point to an old player
+    enet_peer_set_data(peer, NULL);
+
+    // we are full, disconnect them
+    if (FreeSlotCount == 0)
     {
-        if (Players[i].Active && Players[i].Peer == peer)
-            return i;
+        // I said good day SIR!
+        DisconnectPeer(peer);
+        return;
     }
-    return -1;
+
+    // take the next empty slot
+    int playerId = FreeSlots[--FreeSlotCount];
+
+    // player is good, don't give away the slot
+    Players[playerId].Active = true;
+
+    // but don't send out an update to everyone until they give us a good position
+    PlayerStoreSetLive(&World, playerId, false);
+    Players[playerId].Peer = peer;
+    Players[playerId].ConnectId = CurrentConnectId;
+
+    // remember what slot goes with this connection, so we can find it when they send us data
+    enet_peer_set_data(peer, &Players[playerId]);
+
+    // they have not seen any world updates yet, so the first one they get will be a full one
+    Players[playerId].AckedTick = 0;
+
+    // everyone starts at the same place and sends their inputs from sequence number 1
+    World.X[playerId] = SPAWN_X;
+    World.Y[playerId] = SPAWN_Y;
+    World.DX[playerId] = 0;
+    World.DY[playerId] = 0;
+    Players[playerId].LastInput = 0;
+    Players[playerId].NeedsCorrection = false;
+    Players[playerId].MoveTimeBank = 0;
+
+    // everything reliable we send them is batched up and sent at the end of the tick
+    MessageBatchInit(&Players[playerId].Reliable, peer, CHANNEL_RELIABLE, ENET_PACKET_FLAG_RELIABLE, MaxBatchSize, SendPacket);
+
+    // pack up a message to send back to the client to tell them they have been accepted as a player
+    PacketWriter* writer = MessageBatchBegin(&Players[playerId].Reliable, 21);
+    if (writer != NULL)
+    {
+        WriteByte(writer, (uint8_t)AcceptPlayer);      // command for the client
+        WriteUShort(writer, (uint16_t)playerId);       // the player ID so they know who they are
+        WriteByte(writer, AuthoritativeMovement ? ACCEPT_AUTHORITATIVE : 0);   // how they should send us their movement
+        WriteUShort(writer, (uint16_t)TickInterval);   // how long a tick is, so they can tell when each world update was
+
+        // a first guess at the server clock, they will ask for better ones once they are in
+        // this goes out at the end of the tick, so it is a little old when it gets there, but close enough to start with
+        WriteServerClock(writer);
+
+        // where they start
+        WriteBits(writer, World.X[playerId], POSITION_X_BITS);
+        WriteBits(writer, World.Y[playerId], POSITION_Y_BITS);
+    }
+
+    // they can't see anyone until they give us a position
+    // once they do, the next tick will tell them about everyone near them
+    Players[playerId].VisibleCount = 0;
+}
+
+// take the world update tick a player says they have, so we can send them changes from there
+void AcknowledgeTick(int playerId, uint32_t ackedTick)
+{
+    // only take it if it's newer than what we had and not from the future
+    if (ackedTick > Players[playerId].AckedTick && ackedTick <= CurrentTick)
+        Players[playerId].AckedTick = ackedTick;
 }
 
-// sends a packet over the network to every active player, except the one specified (usually the sender)
-// senders know what they sent so you can choose to not send them data they already know.
-// in a truly authoritive server you'd send back an acceptance message to all client input so they know it wasn't rejected.
-void SendToAllBut(ENetPacket* packet, int exceptPlayerId)
+// a player sent us the inputs we have not processed yet
+// we move them for each new one, and send back where they ended up with the next world update
+void HandleMoveInput(int playerId, PacketReader* reader)
 {
-    for (int i = 0; i < MAX_CLIENTS; i++)
+    PlayerInfo* player = &Players[playerId];
+
+    uint32_t ackedTick = ReadInt(reader);
+    uint16_t sequence = ReadUShort(reader);
+    int count = ReadByte(reader);
+
+    // the message was cut short, so don't trust any of it
+    if (reader->Overflow || count > INPUT_HISTORY)
+        return;
+
+    AcknowledgeTick(playerId, ackedTick);
+
+    for (int i = 0; i < count; i++, sequence++)
     {
-        if (!Players[i].Active || i == exceptPlayerId)
+        uint8_t direction = (uint8_t)ReadBits(reader, DIRECTION_BITS);
+        int duration = (int)ReadBits(reader, 8);
+
+        if (reader->Overflow)
+            break;
+
+        // inputs are sent until we tell them we have them, so skip the ones we already did
+        // sequence numbers wrap around, so compare them by how far apart they are
+        if ((int16_t)(sequence - player->LastInput) <= 0)
             continue;
 
-        enet_peer_send(Players[i].Peer, 0, packet);
+        // don't let them move for more time than has passed, this keeps a modified client from moving faster than everyone else
+        if (duration > player->MoveTimeBank)
+            duration = player->MoveTimeBank;
+        player->MoveTimeBank -= duration;
+
+        DecodeDirection(direction, &World.DX[playerId], &World.DY[playerId]);
+        World.X[playerId] = MoveAxis(World.X[playerId], World.DX[playerId], duration, FieldSizeWidth - PlayerSize);
+        World.Y[playerId] = MoveAxis(World.Y[playerId], World.DY[playerId], duration, FieldSizeHeight - PlayerSize);
+
+        player->LastInput = sequence;
     }
+
+    // tell them where they are now, even if nothing was new, they may have missed the last correction
+    player->NeedsCorrection = true;
+
+    // the player has sent us input, they can be part of future regular updates
+    PlayerStoreSetLive(&World, playerId, true);
 }
 
-// the main server loop
-int main()
+// a player wants to know what time it is
+// this is answered right away instead of being batched, the longer it waits the less accurate the answer is
+// with a network thread, it answers these itself as they come in, so this is always sent straight to enet
+void HandleTimeRequest(ENetPeer* peer, PacketReader* reader)
 {
-    printf("Startup\n");
+    uint32_t clientTime = ReadInt(reader);
+    if (reader->Overflow)
+        return;
 
-    // set up networking
-    if (enet_initialize() != 0)
-        return 1;
+    PacketWriter writer;
+    if (!PacketWriterBegin(&writer, 17, ENET_PACKET_FLAG_UNSEQUENCED))
+        return;
 
-    printf("Initialized\n");
+    WriteByte(&writer, (uint8_t)TimeResponse);
+    WriteInt(&writer, clientTime);
+    WriteServerClock(&writer);
 
-    // network servers must 'listen' on an interface and a port
-    // this code sets up enet to listen on any available interface and using our port
-    // the client must use the same port as the server and know the address of the server
-    ENetAddress address = { 0 };
-    address.host = ENET_HOST_ANY;
-    address.port = 4545;
+    ENetPacket* packet = PacketWriterEnd(&writer);
+    if (packet != NULL)
+        enet_peer_send(peer, CHANNEL_UNRELIABLE, packet);
+}
 
-    // create the server host
-    ENetHost* server = enet_host_create(&address, MAX_CLIENTS, 1, 0, 0);
+// someone sent us data
+void HandleReceive(ENetPeer* peer, ENetPacket* packet)
+{
+    // find the player who sent the data
+    // we don't need them to send us what ID they are, we know who they are by the peer
+    // we want to trust the client as little as possible so that people can't cheat/hack
+    // if we blindly accepted a player ID, a client could send you updates for someone else :(
 
-    if (server == NULL)
-        return 1;
+    int playerId = GetPlayerId(peer);
+    if (playerId == -1)
+    {
+        // they are not one of our peeple, boot them
+        DisconnectPeer(peer);
+        return;
+    }
 
-    printf("Created\n");
+    // the reader keeps track of how far into the message we are
+    PacketReader reader;
+    PacketReaderInit(&reader, packet);
 
-    // the server will run forever. If we wanted a way to stop it, we'd set run to false using some code
-    bool run = true;
+    // read off the command the client wants us to process
+    NetworkCommands command = (NetworkCommands)ReadByte(&reader);
 
-    while (run)
+    // clients send one kind of movement message, depending on who is in charge of where they are
+    if (command == TimeRequest)
     {
-        ENetEvent event = { 0 };
+        HandleTimeRequest(peer, &reader);
+    }
+    else if (command == MoveInput && AuthoritativeMovement)
+    {
+        HandleMoveInput(playerId, &reader);
+    }
+    else if (command == UpdateInput && !AuthoritativeMovement)
+    {
+        // the position and direction are bit packed
+        uint16_t x = (uint16_t)ReadBits(&reader, POSITION_X_BITS);
+        uint16_t y = (uint16_t)ReadBits(&reader, POSITION_Y_BITS);
+        uint8_t direction = (uint8_t)ReadBits(&reader, DIRECTION_BITS);
+
+        // remember what world update they have, so we can send them changes from there
+        uint32_t ackedTick = ReadInt(&reader);
+
+        // the message was cut short, so don't trust any of it
+        if (reader.Overflow)
+            return;
+
+        // update the location data with the new info, making sure it is in the field
+        // the direction is only 8 ways at the normal move speed, so nobody can send a faster one
+        // we don't send this out right away, the next server tick will include it in the world update
+        World.X[playerId] = QuantizePosition(x, FieldSizeWidth - PlayerSize);
+        World.Y[playerId] = QuantizePosition(y, FieldSizeHeight - PlayerSize);
+        DecodeDirection(direction, &World.DX[playerId], &World.DY[playerId]);
+
+        AcknowledgeTick(playerId, ackedTick);
+
+        // the player has sent us a position, they can be part of future regular updates
+        // the next tick will tell everyone near them about them
+        PlayerStoreSetLive(&World, playerId, true);
+    }
+}
+
+// a player was disconnected
+void HandleDisconnect(ENetPeer* peer)
+{
+    printf("Player Disconnected\n");
+
+    // find them if they are a real player
+    int playerId = GetPlayerId(peer);
+    if (playerId == -1)
+        return;
+
+    // mark them as inactive and clear the peer pointer
+    Players[playerId].Active = false;
+    PlayerStoreSetLive(&World, playerId, false);
+    Players[playerId].Peer = NULL;
+    enet_peer_set_data(peer, NULL);
+
+    // anything we had waiting for them can't be sent now
+    MessageBatchDiscard(&Players[playerId].Reliable);
+
+    // Tell everyone who could see them that they left
+    // everyone uses the same view radius, so the players they could see are the same ones that could see them
+    for (int i = 0; i < Players[playerId].VisibleCount; i++)
+    {
+        PlayerInfo* other = &Players[Players[playerId].Visible[i].Id];
+
+        SendRemovePlayer(other, playerId);
 
-        // see if there are any inbound network events, wait up to 1000ms before returning.
-        // if the server also did game logic, this timeout should be lowered
-        if (enet_host_service(server, &event, 1000) > 0)
+        // take them out of the other player's list, order doesn't matter so move the last one into their spot
+        for (int j = 0; j < other->VisibleCount; j++)
         {
-            // see what kind of event we have
-            switch (event.type)
+            if (other->Visible[j].Id == playerId)
             {
+                other->Visible[j] = other->Visible[--other->VisibleCount];
+                break;
+            }
+        }
+    }
 
-            // a new client is trying to connect
-            case ENET_EVENT_TYPE_CONNECT:
-            {
-                printf("Player Connected\n");
+    Players[playerId].VisibleCount = 0;
 
-                // find an empty slot, or disconnect them if we are full
-                int playerId = 0;
-                for (; playerId < MAX_CLIENTS; playerId++)
-                {
-                    if (!Players[playerId].Active)
-                        break;
-                }
+    // give the slot back for someone else to use
+    FreeSlots[FreeSlotCount++] = playerId;
+}
 
-                // we are full
-                if (playerId == MAX_CLIENTS)
-                {
-                    // I said good day SIR!
-                    enet_peer_disconnect(event.peer, 0);
-                    break;
-                }
+// process one event from enet, from a peer with a connection id
+void HandleEvent(ENetEvent* event, enet_uint32 connectId)
+{
+    CurrentConnectId = connectId;
+
+    // see what kind of event we have
+    switch (event->type)
+    {
+    case ENET_EVENT_TYPE_CONNECT:
+        HandleConnect(event->peer);
+        break;
+
+    case ENET_EVENT_TYPE_RECEIVE:
+        HandleReceive(event->peer, event->packet);
+
+        // tell enet that it can recycle the inbound packet
+        enet_packet_destroy(event->packet);
+        break;
+
+    case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
+    case ENET_EVENT_TYPE_DISCONNECT:
+        HandleDisconnect(event->peer);
+        break;
+
+    case ENET_EVENT_TYPE_NONE:
+        break;
+    }
+}
+
+// advance the server simulation by one tick
+// clients only tell us where they are every so often, so move everyone along their last known direction
+// until we hear from them again, this way the world update we send out is where we think they are right now
+// when the server is authoritative, players are moved by their inputs as they come in instead
+void SimulateTick()
+{
+    CurrentTick++;
+
+    if (AuthoritativeMovement)
+    {
+        // give everyone more time to move
+        for (int i = PlayerStoreNextLive(&World, -1); i >= 0; i = PlayerStoreNextLive(&World, i))
+        {
+            Players[i].MoveTimeBank += TickInterval;
+            if (Players[i].MoveTimeBank > MAX_MOVE_TIME_BANK)
+                Players[i].MoveTimeBank = MAX_MOVE_TIME_BANK;
+        }
+    }
+    else
+    {
+        // move everyone at once, players that are not live get moved too, but nothing looks at them
+        PlayerStoreIntegrate(&World, TickInterval);
+        PlayerStoreClamp(&World, FieldSizeWidth - PlayerSize, FieldSizeHeight - PlayerSize);
+    }
 
-                // player is good, don't give away the slot
-                Players[playerId].Active = true;
+    // we keep a copy of the world for every tick so we can send deltas from it later
+    WorldState* world = &History[CurrentTick % SNAPSHOT_HISTORY];
+    world->Tick = CurrentTick;
+    PlayerStoreCopy(&world->Players, &World);
 
-                // but don't send out an update to everyone until they give us a good position
-                Players[playerId].ValidPosition = false;
-                Players[playerId].Peer = event.peer;
+    // and a longer history of just positions, for lag compensation
+    LagHistoryRecord(&Rewind, CurrentTick, World.X, World.Y, World.Live);
 
-                // pack up a message to send back to the client to tell them they have been accepted as a player
-                uint8_t buffer[2] = { 0 };
-                buffer[0] = (uint8_t)AcceptPlayer;  // command for the client
-                buffer[1] = (uint8_t)playerId;      // the player ID so they know who they are
+    // time requests are answered with this tick from now on
+    PublishClock();
+}
+
+// get the world update that a player has, so we can send them only what changed since then
+// returns NULL if they don't have one we still know about, and need a full update
+WorldState* GetBaseWorld(PlayerInfo* player)
+{
+    if (player->AckedTick == 0 || CurrentTick - player->AckedTick >= SNAPSHOT_HISTORY)
+        return NULL;
+
+    WorldState* base = &History[player->AckedTick % SNAPSHOT_HISTORY];
+    if (base->Tick != player->AckedTick)
+        return NULL;
+
+    return base;
+}
+
+// get what changed for every player since a base world update
+// this is worked out for every player at once the first time it is needed in a tick, and then shared by everyone with the same base
+const uint8_t* GetChangeMasks(const WorldState* base)
+{
+    uint32_t age = CurrentTick - base->Tick;
+    if (ChangeMaskTick[age] != CurrentTick)
+    {
+        PlayerStoreDiff(&History[CurrentTick % SNAPSHOT_HISTORY].Players, &base->Players, ChangeMasks[age]);
+        ChangeMaskTick[age] = CurrentTick;
+    }
+
+    return ChangeMasks[age];
+}
+
+// write the fields in the mask for one player into a world update
+void WritePlayerState(PacketWriter* writer, int playerId, uint8_t mask, const PlayerStore* world)
+{
+    WriteVarBits(writer, (uint16_t)playerId);
+    WriteBits(writer, mask, FIELD_BITS);
+
+    if (mask & FIELD_X)
+        WriteBits(writer, world->X[playerId], POSITION_X_BITS);
+    if (mask & FIELD_Y)
+        WriteBits(writer, world->Y[playerId], POSITION_Y_BITS);
+    if (mask & FIELD_DIR)
+        WriteBits(writer, EncodeDirection(world->DX[playerId], world->DY[playerId]), DIRECTION_BITS);
+}
+
+// work out who a player can see now, and tell them about anyone that came into or went out of view
+void UpdateVisiblePlayers(int playerId)
+{
+    PlayerInfo* player = &Players[playerId];
+
+    // the stamp is about to wrap around, so clear the marks so an old one can't match a new stamp
+    if (InterestStamp >= UINT32_MAX - 2)
+    {
+        memset(InterestMark, 0, sizeof(uint32_t) * MaxClients);
+        InterestStamp = 0;
+    }
+
+    // mark everyone they could see before, and remember where they were in the list
+    uint32_t before = ++InterestStamp;
+    for (int i = 0; i < player->VisibleCount; i++)
+    {
+        InterestMark[player->Visible[i].Id] = before;
+        InterestIndex[player->Visible[i].Id] = i;
+    }
+
+    // find everyone that is close enough
+    int* nearby = NearbyPlayers;
+    int nearbyCount = InterestGridQuery(&Grid, World.X[playerId], World.Y[playerId], ViewRadius, nearby, MaxClients);
+
+    // make sure their list is big enough, it only ever grows so this settles down quickly
+    // do this before anything is sent, so if we run out of memory they just keep seeing who they saw before
+    if (nearbyCount > player->VisibleCapacity)
+    {
+        int capacity = player->VisibleCapacity * 2;
+        if (capacity < nearbyCount)
+            capacity = nearbyCount;
+
+        VisiblePlayer* grown = (VisiblePlayer*)realloc(player->Visible, sizeof(VisiblePlayer) * capacity);
+        if (grown == NULL)
+            return;
+
+        player->Visible = grown;
+        player->VisibleCapacity = capacity;
+    }
+
+    // build the new list, keeping when they first saw anyone they could already see
+    uint32_t now = ++InterestStamp;
+    VisiblePlayer* visible = VisibleScratch;
+    int visibleCount = 0;
+
+    for (int i = 0; i < nearbyCount; i++)
+    {
+        int otherId = nearby[i];
+
+        // they know where they are
+        if (otherId == playerId)
+            continue;
+
+        VisiblePlayer* entry = &visible[visibleCount++];
+        entry->Id = otherId;
+
+        if (InterestMark[otherId] == before)
+        {
+            entry->Since = player->Visible[InterestIndex[otherId]].Since;
+        }
+        else
+        {
+            // they just came into view, so this tick is the first world update they will be in
+            entry->Since = CurrentTick;
+            SendAddPlayer(player, otherId);
+        }
+
+        InterestMark[otherId] = now;
+    }
+
+    // anyone that was in the old list and was not found again has gone out of view
+    for (int i = 0; i < player->VisibleCount; i++)
+    {
+        if (InterestMark[player->Visible[i].Id] != now)
+            SendRemovePlayer(player, player->Visible[i].Id);
+    }
 
-                // copy the buffer into an enet packet (TODO : add write functions to go directly to a packet)
-                ENetPacket* packet = enet_packet_create(buffer, 2, ENET_PACKET_FLAG_RELIABLE);
-                // send the data to the user
-                enet_peer_send(event.peer, 0, packet);
+    memcpy(player->Visible, visible, sizeof(VisiblePlayer) * visibleCount);
+    player->VisibleCount = visibleCount;
+}
 
-                // We have to tell the new client about all the other players that are already on the server
-                // so send them an add message for all existing active players.
-                for (int i = 0; i < MAX_CLIENTS; i++)
+// update who can see who for all players
+void UpdateInterest()
+{
+    // put everyone with a position into the grid
+    InterestGridClear(&Grid);
+    for (int i = PlayerStoreNextLive(&World, -1); i >= 0; i = PlayerStoreNextLive(&World, i))
+        InterestGridAdd(&Grid, i, World.X[i], World.Y[i]);
+    InterestGridBuild(&Grid);
+
+    // and then see who is near each of them
+    for (int i = PlayerStoreNextLive(&World, -1); i >= 0; i = PlayerStoreNextLive(&World, i))
+        UpdateVisiblePlayers(i);
+}
+
+// start a new part of a world update, with room for the players that are left to send
+// 1 byte for the command, 4 bytes for the tick, 1 byte for the base, 1 byte for the part number and 2 bytes for the count
+// the count is filled in when the part is sent, from the header offset
+// if the player needs a correction, it goes in front of the first part
+bool BeginUpdatePart(PacketWriter* writer, PlayerInfo* recipient, int playersLeft, uint8_t baseAge, int part, size_t* headerOffset)
+{
+    bool correction = part == 0 && recipient->NeedsCorrection;
+
+    // each player takes up to 6 bytes (up to 16+2 bits for the ID, 3 for the mask, and 25 for the position and direction)
+    // parts are never bigger than a datagram, except the last part we are allowed to send which takes whatever is left
+    // enet will split that one up if it has to
+    size_t capacity = (correction ? 19 : 9) + (size_t)playersLeft * 6;
+    if (capacity > MaxBatchSize && part < MAX_UPDATE_PARTS - 1)
+        capacity = MaxBatchSize;
+
+    // world updates are unsequenced, the tick in the update lets the client throw away any that show up late
+    if (!PacketWriterBegin(writer, capacity, ENET_PACKET_FLAG_UNSEQUENCED))
+        return false;
+
+    // the last input we processed for them, and where it left them
+    if (correction)
+    {
+        WriteByte(writer, (uint8_t)CorrectPlayer);
+        WriteInt(writer, CurrentTick);
+        WriteUShort(writer, recipient->LastInput);
+        WriteBits(writer, World.X[recipient - Players], POSITION_X_BITS);
+        WriteBits(writer, World.Y[recipient - Players], POSITION_Y_BITS);
+
+        // the last bits of the position are only written when the next byte is, so finish them before we remember where the header is
+        PacketWriterAlign(writer);
+    }
+
+    *headerOffset = writer->Offset;
+
+    WriteByte(writer, (uint8_t)UpdatePlayer);
+    WriteInt(writer, CurrentTick);
+
+    // the base is always less than SNAPSHOT_HISTORY ticks old, so just send how old it is
+    WriteByte(writer, baseAge);
+    WriteByte(writer, (uint8_t)part);
+
+    // we don't know how many players will be in it yet
+    WriteUShort(writer, 0);
+    return true;
+}
+
+// fill in the count and send one part of a world update
+void SendUpdatePart(PlayerInfo* recipient, PacketWriter* writer, size_t headerOffset, int part, uint16_t count, bool last)
+{
+    if (last)
+        WriteByteAt(writer, headerOffset + 6, (uint8_t)(part | UPDATE_PART_LAST));
+    WriteUShortAt(writer, headerOffset + 7, count);
+
+    ENetPacket* packet = PacketWriterEnd(writer);
+    if (packet != NULL)
+        SendPacket(recipient->Peer, CHANNEL_UNRELIABLE, packet);
+}
+
+// send a world update to one player with all the players they can see
+// if they have told us about an update they got, only the players that changed since then are sent
+// the update is packed into as few datagrams as it will fit in, splitting it into parts if it has to
+void SendWorldUpdate(int recipientId)
+{
+    PlayerInfo* recipient = &Players[recipientId];
+    const PlayerStore* world = &History[CurrentTick % SNAPSHOT_HISTORY].Players;
+    WorldState* base = GetBaseWorld(recipient);
+    const uint8_t* changes = base != NULL ? GetChangeMasks(base) : NULL;
+    uint8_t baseAge = base != NULL ? (uint8_t)(CurrentTick - base->Tick) : 0;
+
+    // if a part is lost, the client never acknowledges this update, so the next update is built from an update they did get
+    int part = 0;
+    size_t headerOffset = 0;
+    bool correction = recipient->NeedsCorrection;
+    PacketWriter writer;
+    if (!BeginUpdatePart(&writer, recipient, recipient->VisibleCount, baseAge, part, &headerOffset))
+        return;
+
+    recipient->NeedsCorrection = false;
+
+    uint16_t count = 0;
+    int total = 0;
+
+    for (int v = 0; v < recipient->VisibleCount; v++)
+    {
+        int i = recipient->Visible[v].Id;
+
+        // assume they need everything
+        uint8_t mask = FIELD_ALL;
+
+        // if they got an update with this player in it, only send what is different
+        if (base != NULL && base->Tick >= recipient->Visible[v].Since)
+        {
+            mask = changes[i];
+
+            // nothing changed, this player costs nothing
+            if (mask == 0)
+                continue;
+        }
+
+        // this part is full, send it and start the next one
+        // the 7 covers the biggest player and a partly written byte
+        if (writer.Offset + 7 > MaxBatchSize && count > 0 && part < MAX_UPDATE_PARTS - 1)
+        {
+            SendUpdatePart(recipient, &writer, headerOffset, part, count, false);
+            part++;
+
+            if (!BeginUpdatePart(&writer, recipient, recipient->VisibleCount - v, baseAge, part, &headerOffset))
+                return;
+
+            count = 0;
+        }
+
+        WritePlayerState(&writer, i, mask, world);
+        count++;
+        total++;
+    }
+
+    // if nothing changed and their base is recent, we don't need to send anything at all
+    // once the base gets old we send an empty update anyway, so they acknowledge a newer one before it falls out of our history
+    // a correction always goes out, or they would keep sending inputs we already have
+    if (total == 0 && !correction && base != NULL && CurrentTick - base->Tick < SNAPSHOT_HISTORY / 2)
+    {
+        PacketWriterDiscard(&writer);
+        return;
+    }
+
+    SendUpdatePart(recipient, &writer, headerOffset, part, count, true);
+}
+
+// send one player the reliable messages that were batched up during the tick, and their world update
+// this only changes data for that player, so it can run for many players at the same time
+void SendPlayerMessages(void* context, int playerId, int worker)
+{
+    // everything this needs is global, so the work context isn't used
+    (void)context;
+
+    CurrentWorker = worker;
+
+    if (!Players[playerId].Active)
+        return;
+
+    MessageBatchFlush(&Players[playerId].Reliable);
+
+    if (PlayerStoreIsLive(&World, playerId))
+        SendWorldUpdate(playerId);
+}
+
+// send the current world to every connected player, along with any reliable messages that were batched up during the tick
+// this is one reliable packet and one world update per player per tick, unless there is more than fits in a datagram
+// building and packing the updates is split up between the worker threads
+void SendWorldUpdates()
+{
+    // work out what changed since every base world anyone has first, so the workers only read it
+    for (int i = PlayerStoreNextLive(&World, -1); i >= 0; i = PlayerStoreNextLive(&World, i))
+    {
+        WorldState* base = GetBaseWorld(&Players[i]);
+        if (base != NULL)
+            GetChangeMasks(base);
+    }
+
+    WorkerPoolRun(&Workers, SendPlayerMessages, NULL, MaxClients);
+    CurrentWorker = 0;
+}
+
+// allocate all the player data for the number of players we allow
+// returns false if there is not enough memory
+bool InitPlayers()
+{
+    Players = (PlayerInfo*)calloc(MaxClients, sizeof(PlayerInfo));
+    FreeSlots = (int*)malloc(sizeof(int) * MaxClients);
+    InterestMark = (uint32_t*)calloc(MaxClients, sizeof(uint32_t));
+    InterestIndex = (int*)calloc(MaxClients, sizeof(int));
+    NearbyPlayers = (int*)malloc(sizeof(int) * MaxClients);
+    VisibleScratch = (VisiblePlayer*)malloc(sizeof(VisiblePlayer) * MaxClients);
+
+    if (Players == NULL || FreeSlots == NULL || InterestMark == NULL || InterestIndex == NULL ||
+        NearbyPlayers == NULL || VisibleScratch == NULL)
+        return false;
+
+    if (!PlayerStoreInit(&World, MaxClients))
+        return false;
+
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+    {
+        ChangeMasks[i] = (uint8_t*)malloc(World.Capacity);
+        if (!PlayerStoreInit(&History[i].Players, MaxClients) || ChangeMasks[i] == NULL)
+            return false;
+    }
+
+    // push the slots on backwards, so the lowest ids get used first
+    for (int i = MaxClients - 1; i >= 0; i--)
+        FreeSlots[FreeSlotCount++] = i;
+
+    return true;
+}
+
+// release all the player data
+void FreePlayers()
+{
+    if (Players != NULL)
+    {
+        for (int i = 0; i < MaxClients; i++)
+        {
+            free(Players[i].Visible);
+
+            if (Players[i].Active)
+                MessageBatchDiscard(&Players[i].Reliable);
+        }
+    }
+
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+    {
+        PlayerStoreFree(&History[i].Players);
+        free(ChangeMasks[i]);
+    }
+
+    PlayerStoreFree(&World);
+
+    free(Players);
+    free(FreeSlots);
+    free(InterestMark);
+    free(InterestIndex);
+    free(NearbyPlayers);
+    free(VisibleScratch);
+}
+
+// the network thread for one shard
+// it sends the packets the other threads give it, answers time requests as soon as they come in,
+// and passes every other event on to the simulation, which handles them all at the start of the next tick
+void NetworkThreadMain(void* argument)
+{
+    NetworkShard* shard = (NetworkShard*)argument;
+
+    // an event there was no room for in the inbound queue
+    InboundEvent pending = { 0 };
+    bool hasPending = false;
+
+    while (AtomicLoad(&NetworkRunning))
+    {
+        // send everything that is waiting, as long as the peer is still the connection it was made for
+        bool sent = false;
+        for (int i = 0; i <= WorkerThreads; i++)
+        {
+            OutboundPacket message;
+            while (SpscQueuePop(&shard->OutboundQueues[i], &message))
+            {
+                sent = true;
+                bool current = message.Peer->connectID == message.ConnectId && message.Peer->state == ENET_PEER_STATE_CONNECTED;
+
+                if (message.Packet == NULL)
                 {
-                    // only people who are valid and not the new player
-                    if (i == playerId || !Players[i].ValidPosition)
-                        continue;
-
-                    // pack up an add player message with the ID and the last known position
-                    uint8_t addBuffer[10] = { 0 };
-                    addBuffer[0] = (uint8_t)AddPlayer;
-                    addBuffer[1] = (uint8_t)i;
-                    *(int16_t*)(addBuffer + 2) = (int16_t)Players[i].X;
-                    *(int16_t*)(addBuffer + 4) = (int16_t)Players[i].Y;
-                    *(int16_t*)(addBuffer + 6) = (int16_t)Players[i].DX;
-                    *(int16_t*)(addBuffer + 8) = (int16_t)Players[i].DY;
-
-                    // Optimally we'd also send other info like name, color, and other static player info.
-
-                    // copy and send the message
-                    packet = enet_packet_create(addBuffer, 10, ENET_PACKET_FLAG_RELIABLE);
-                    enet_peer_send(event.peer, 0, packet);
-
-                    // NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-                    // you don't have to destroy them
+                    if (current)
+                        enet_peer_disconnect(message.Peer, 0);
+                }
+                else if (!current || enet_peer_send(message.Peer, message.Channel, message.Packet) < 0)
+                {
+                    enet_packet_destroy(message.Packet);
                 }
-                break;
             }
+        }
 
-            // someone sent us data
-            case ENET_EVENT_TYPE_RECEIVE:
+        // push the world updates out now, instead of waiting for the next service call
+        if (sent)
+            enet_host_flush(shard->Host);
+
+        // the simulation has not taken what we have already, so don't get any more until it does
+        if (hasPending)
+        {
+            if (!SpscQueuePush(&shard->InboundQueue, &pending))
             {
-                // find the player who sent the data
-                // we don't need them to send us what ID they are, we know who they are by the peer
-                // we want to trust the client as little as possible so that people can't cheat/hack
-                // if we blindly accepted a player ID, a client could send you updates for someone else :(
+                ThreadSleep(NETWORK_THREAD_INTERVAL);
+                continue;
+            }
+            hasPending = false;
+        }
 
-                int playerId = GetPlayerId(event.peer);
-                if (playerId == -1)
+        // take everything enet has for us without waiting
+        // enet_host_service stops early to give us an event, so keep calling it until it has nothing left,
+        // otherwise datagrams it had already read from the socket would sit there until the next time we wake up
+        ENetEvent event = { 0 };
+        int result = enet_host_service(shard->Host, &event, 0);
+        while (result > 0)
+        {
+            if (event.type == ENET_EVENT_TYPE_RECEIVE && event.packet->dataLength > 0 && event.packet->data[0] == TimeRequest)
+            {
+                PacketReader reader;
+                PacketReaderInit(&reader, event.packet);
+                ReadByte(&reader);
+                HandleTimeRequest(event.peer, &reader);
+                enet_packet_destroy(event.packet);
+            }
+            else
+            {
+                InboundEvent message = { event.type, event.peer, event.peer->connectID, event.packet };
+                if (!SpscQueuePush(&shard->InboundQueue, &message))
                 {
-                    // they are not one of our peeple, boot them
-                    enet_peer_disconnect(event.peer, 0);
+                    pending = message;
+                    hasPending = true;
                     break;
                 }
+            }
+
+            result = enet_host_check_events(shard->Host, &event);
+            if (result == 0)
+                result = enet_host_service(shard->Host, &event, 0);
+        }
+
+        if (hasPending)
+            continue;
+
+        ENetPoolStats stats;
+        enet_host_get_command_pool_stats(shard->Host, &stats);
+        AtomicStore64(&shard->CommandPoolHits, stats.hits);
+        AtomicStore64(&shard->CommandPoolMisses, stats.misses);
+
+        // sleep until a client sends something, another thread has packets for us, or enet needs servicing
+        HostWaiterWait(&shard->Waiter, NETWORK_SERVICE_INTERVAL);
+    }
+}
+
+// wake the network threads up to send what the simulation and workers gave them
+void WakeNetworkThreads()
+{
+    for (int i = 0; i < ShardCount; i++)
+        HostWaiterWake(&Shards[i].Waiter);
+}
+
+// create a host on the server port
+// when the port is shared, each host sets SO_REUSEPORT before it binds, so they can all have it
+ENetHost* CreateServerHost(const ENetAddress* address, bool shared)
+{
+    if (!shared)
+        return enet_host_create(address, MaxClients, CHANNEL_COUNT, 0, 0);
+
+    // each shard has room for every player, the player slots limit how many get in
+    ENetHost* host = enet_host_create(NULL, MaxClients, CHANNEL_COUNT, 0, 0);
+    if (host == NULL)
+        return NULL;
+
+    if (enet_socket_set_option(host->socket, ENET_SOCKOPT_REUSEPORT, 1) < 0 || enet_socket_bind(host->socket, address) < 0)
+    {
+        enet_host_destroy(host);
+        return NULL;
+    }
+
+    if (enet_socket_get_address(host->socket, &host->address) < 0)
+        host->address = *address;
+
+    return host;
+}
+
+// create a host for each shard
+// returns false if they could not all be created
+bool CreateShards(const ENetAddress* address)
+{
+    Shards = (NetworkShard*)calloc(ShardCount, sizeof(NetworkShard));
+    if (Shards == NULL)
+        return false;
+
+    for (int i = 0; i < ShardCount; i++)
+    {
+        Shards[i].Host = CreateServerHost(address, ShardCount > 1);
+        if (Shards[i].Host == NULL)
+            return false;
+
+        // a tick sends a world update to everyone at once, so send all of those datagrams with one call where we can
+        // where we can't, enet just sends them one at a time
+        enet_host_set_send_batching(Shards[i].Host, 1);
+
+        // the commands that carry packets come and go with every send and acknowledgement, so keep them for reuse too
+        enet_host_set_command_pool(Shards[i].Host, 1);
+
+        // io_uring takes over all of the host's reads and writes if it can, otherwise we keep going without it
+        if (UseIoUring && enet_host_set_io_uring(Shards[i].Host, 1) < 0)
+        {
+            printf("io_uring is not available, using normal socket calls\n");
+            UseIoUring = false;
+        }
+    }
+
+    return true;
+}
+
+// start a network thread for each shard and the queues to and from them
+// returns false if they could not be started
+bool StartNetworkThreads()
+{
+    for (int i = 0; i < ShardCount; i++)
+    {
+        NetworkShard* shard = &Shards[i];
+
+        shard->OutboundQueues = (SpscQueue*)calloc(WorkerThreads + 1, sizeof(SpscQueue));
+        if (shard->OutboundQueues == NULL)
+            return false;
+
+        if (!SpscQueueInit(&shard->InboundQueue, MaxClients * INBOUND_EVENTS_PER_PLAYER, sizeof(InboundEvent)))
+            return false;
+
+        for (int j = 0; j <= WorkerThreads; j++)
+        {
+            if (!SpscQueueInit(&shard->OutboundQueues[j], OUTBOUND_QUEUE_SIZE, sizeof(OutboundPacket)))
+                return false;
+        }
+
+        if (!HostWaiterInit(&shard->Waiter))
+            return false;
+
+        shard->HasWaiter = true;
+        if (!HostWaiterAdd(&shard->Waiter, shard->Host))
+            return false;
+    }
 
-                // keep track of how far into the message we are
-                size_t offset = 0;
+    // the simulation starts sending to the queues as soon as this is set, so only set it once they all exist
+    Pipelined = true;
+    NetworkRunning = 1;
 
-                // read off the command the client wants us to process
-                NetworkCommands command = ReadByte(event.packet, &offset);
+    for (int i = 0; i < ShardCount; i++)
+    {
+        if (!ThreadStart(&Shards[i].Thread, NetworkThreadMain, &Shards[i]))
+            return false;
+
+        Shards[i].Started = true;
+    }
+
+    return true;
+}
+
+// stop the network threads, throw away anything still in the queues and destroy the hosts
+void FreeShards()
+{
+    if (Shards == NULL)
+        return;
+
+    if (Pipelined)
+    {
+        AtomicStore(&NetworkRunning, 0);
+        WakeNetworkThreads();
+        for (int i = 0; i < ShardCount; i++)
+        {
+            if (Shards[i].Started)
+                ThreadJoin(&Shards[i].Thread);
+        }
+        Pipelined = false;
+    }
 
-                // we only accept one message from clients for now, so make sure this is what it is
-                if (command == UpdateInput)
+    for (int i = 0; i < ShardCount; i++)
+    {
+        NetworkShard* shard = &Shards[i];
+
+        InboundEvent inbound;
+        while (shard->InboundQueue.Items != NULL && SpscQueuePop(&shard->InboundQueue, &inbound))
+        {
+            if (inbound.Packet != NULL)
+                enet_packet_destroy(inbound.Packet);
+        }
+        SpscQueueFree(&shard->InboundQueue);
+
+        if (shard->OutboundQueues != NULL)
+        {
+            for (int j = 0; j <= WorkerThreads; j++)
+            {
+                OutboundPacket outbound;
+                while (shard->OutboundQueues[j].Items != NULL && SpscQueuePop(&shard->OutboundQueues[j], &outbound))
                 {
-                    // update the location data with the new info
-                    Players[playerId].X = ReadShort(event.packet, &offset);
-                    Players[playerId].Y = ReadShort(event.packet, &offset);
-                    Players[playerId].DX = ReadShort(event.packet, &offset);
-                    Players[playerId].DY = ReadShort(event.packet, &offset);
-
-                    // lets tell everyone about this new location
-                    NetworkCommands outboundCommand = UpdatePlayer;
-
-                    // if they are new, send this update as an add player instead of an update
-                    if (!Players[playerId].ValidPosition)
-                        outboundCommand = AddPlayer;
-
-                    // the player has sent us a position, they can be part of future regular updates
-                    Players[playerId].ValidPosition = true;
-
-                    // pack up the update message with command, player and position
-                    uint8_t buffer[10] = { 0 };
-                    buffer[0] = (uint8_t)outboundCommand;
-                    buffer[1] = (uint8_t)playerId;
-                    *(int16_t*)(buffer + 2) = (int16_t)Players[playerId].X;
-                    *(int16_t*)(buffer + 4) = (int16_t)Players[playerId].Y;
-                    *(int16_t*)(buffer + 6) = (int16_t)Players[playerId].DX;
-                    *(int16_t*)(buffer + 8) = (int16_t)Players[playerId].DY;
-
-
-                    // Copy and send the data to everyone but the player who sent it  (TODO : add write functions to go directly to a packet)
-                    ENetPacket* packet = enet_packet_create(buffer, 10, ENET_PACKET_FLAG_RELIABLE);
-                    SendToAllBut(packet, playerId);
-
-                    // NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-                    // you don't have to destroy them
+                    if (outbound.Packet != NULL)
+                        enet_packet_destroy(outbound.Packet);
                 }
-
-                // tell enet that it can recycle the inbound packet
-                enet_packet_destroy(event.packet);
-                break;
+                SpscQueueFree(&shard->OutboundQueues[j]);
             }
-            case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT:
-            case ENET_EVENT_TYPE_DISCONNECT:
-            {
-                // a player was disconnected
-                printf("Player Disconnected\n");
-                
-                // find them if they are a real player
-                int playerId = GetPlayerId(event.peer);
-                if (playerId == -1)
-                    break;
+        }
+        free(shard->OutboundQueues);
 
-                // mark them as inactive and clear the peer pointer
-                Players[playerId].Active = false;
-                Players[playerId].Peer = NULL;
+        if (shard->HasWaiter)
+            HostWaiterFree(&shard->Waiter);
 
-                // Tell everyone that someone left
-                uint8_t buffer[2] = { 0 };
-                buffer[0] = (uint8_t)RemovePlayer;
-                buffer[1] = (uint8_t)playerId;
+        if (shard->Host != NULL)
+            enet_host_destroy(shard->Host);
+    }
 
-                // Copy and send the data to everyone but the player who sent it  (TODO : add write functions to go directly to a packet)
-                ENetPacket* packet = enet_packet_create(buffer, 2, ENET_PACKET_FLAG_RELIABLE);
-                SendToAllBut(packet, -1);
+    free(Shards);
+    Shards = NULL;
+}
 
-                // NOTE enet_host_service will handle releasing send packets when the network system has finally sent them,
-                   // you don't have to destroy them
+// print how the server is doing, dropped batches and how well the allocation pools are working
+void PrintStatus()
+{
+    uint32_t dropped = MessageBatchGetDropped();
+    if (dropped > 0)
+        printf("%u batches of messages have been dropped because they did not fit in their packet\n", dropped);
 
-                break;
+    // how often enet's allocations are being served from the pools instead of malloc, misses that keep growing mean churn
+    ENetPoolStats stats;
+    enet_pool_get_stats(&stats);
+    printf("Packet pool: %llu hits, %llu misses (%llu too big for it), %llu blocks cached\n",
+        (unsigned long long)stats.hits, (unsigned long long)stats.misses, (unsigned long long)stats.oversize, (unsigned long long)stats.cached);
+
+    for (int i = 0; i < ShardCount; i++)
+    {
+        // without network threads the hosts are ours, so ask them directly
+        if (!Pipelined)
+            enet_host_get_command_pool_stats(Shards[i].Host, &stats);
+        else
+        {
+            stats.hits = AtomicLoad64(&Shards[i].CommandPoolHits);
+            stats.misses = AtomicLoad64(&Shards[i].CommandPoolMisses);
+        }
+
+        printf("Shard %d command pool: %llu hits, %llu misses\n", i, (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+    }
+}
+
+// the main server loop
+// an optional tick rate (in updates per second), view radius (in pixels), max players, authoritative movement (1 or 0),
+// number of worker threads, number of shards and io_uring (1 or 0) can be passed on the command line
+int main(int argc, char** argv)
+{
+    printf("Startup\n");
+
+    int tickRate = DEFAULT_TICK_RATE;
+    if (argc > 1)
+        tickRate = atoi(argv[1]);
+
+    if (tickRate <= 0 || tickRate > MAX_TICK_RATE)
+    {
+        printf("Invalid tick rate %s, must be between 1 and %d\n", argv[1], MAX_TICK_RATE);
+        return 1;
+    }
+
+    if (argc > 2)
+        ViewRadius = atoi(argv[2]);
+
+    if (ViewRadius <= 0)
+    {
+        printf("Invalid view radius %s\n", argv[2]);
+        return 1;
+    }
+
+    if (ViewRadius > MAX_VIEW_RADIUS)
+        ViewRadius = MAX_VIEW_RADIUS;
+
+    if (argc > 3)
+        MaxClients = atoi(argv[3]);
+
+    if (MaxClients <= 0 || MaxClients > MAX_PLAYERS)
+    {
+        printf("Invalid max players %s, must be between 1 and %d\n", argv[3], MAX_PLAYERS);
+        return 1;
+    }
+
+    if (argc > 4)
+        AuthoritativeMovement = atoi(argv[4]) != 0;
+
+    if (argc > 5)
+        WorkerThreads = atoi(argv[5]);
+
+    if (WorkerThreads < 0)
+    {
+        printf("Invalid worker threads %s\n", argv[5]);
+        return 1;
+    }
+
+    if (argc > 6)
+        ShardCount = atoi(argv[6]);
+
+    if (ShardCount <= 0)
+    {
+        printf("Invalid shard count %s\n", argv[6]);
+        return 1;
+    }
+
+    if (argc > 7)
+        UseIoUring = atoi(argv[7]) != 0;
+
+    TickInterval = 1000 / tickRate;
+
+    // keep enough ticks to cover the time, this is allocated once and never grows
+    if (!LagHistoryInit(&Rewind, MaxClients, tickRate * LAG_HISTORY_SECONDS))
+        return 1;
+
+    if (!InitPlayers())
+        return 1;
+
+    // the grid cells are as big as the view radius, so finding who is near someone only needs to look at the cells around them
+    if (!InterestGridInit(&Grid, FieldSizeWidth, FieldSizeHeight, ViewRadius, MaxClients))
+        return 1;
+
+    // set up networking
+    // every world update is a new packet, so let enet reuse freed blocks instead of asking malloc each time
+    // packets are made on the workers and freed on the network threads, the pool is fine with that
+    ENetCallbacks allocator = { 0 };
+    allocator.malloc = enet_pool_malloc;
+    allocator.free = enet_pool_free;
+    if (enet_initialize_with_callbacks(ENET_VERSION, &allocator) != 0)
+        return 1;
+
+    printf("Initialized\n");
+
+    // network servers must 'listen' on an interface and a port
+    // this code sets up enet to listen on any available interface and using our port
+    // the client must use the same port as the server and know the address of the server
+    ENetAddress address = { 0 };
+    address.host = ENET_HOST_ANY;
+    address.port = SERVER_PORT;
+
+    // create the server hosts
+    if (!CreateShards(&address))
+    {
+        if (ShardCount > 1)
+            printf("Could not share the server port between %d hosts\n", ShardCount);
+        return 1;
+    }
+
+    ENetHost* server = Shards[0].Host;
+
+    // batch messages up into packets that fit in one datagram
+    MaxBatchSize = enet_host_get_mtu(server) - BATCH_HEADER_OVERHEAD;
+
+    // with worker threads or more than one shard, the network gets threads of its own too
+    if (!WorkerPoolInit(&Workers, WorkerThreads))
+        return 1;
+
+    if ((WorkerThreads > 0 || ShardCount > 1) && !StartNetworkThreads())
+        return 1;
+
+    printf("Created, running at %d ticks per second with a view radius of %d for up to %d players\n", tickRate, ViewRadius, MaxClients);
+    printf("Player movement is %s\n", AuthoritativeMovement ? "authoritative" : "trusted from clients");
+    if (UseIoUring)
+        printf("Socket reads and writes go through io_uring\n");
+    if (Pipelined)
+        printf("Network has %d threads sharing the port, world updates are built on %d worker threads and the main thread\n", ShardCount, WorkerThreads);
+
+    // the server runs the simulation on a fixed clock, so the work it does does not depend on how many packets come in
+    enet_uint32 tickInterval = (enet_uint32)TickInterval;
+    enet_uint32 nextTick = enet_time_get() + tickInterval;
+
+    // the server will run forever. If we wanted a way to stop it, we'd set run to false using some code
+    bool run = true;
+
+    // print how things are going every so often, counted in ticks so it happens between them
+    uint32_t statusTicks = (uint32_t)tickRate * STATUS_INTERVAL;
+
+    while (run)
+    {
+        enet_uint32 now = enet_time_get();
+
+        // until it is time for the next tick, wait for network events
+        if (ENET_TIME_LESS(now, nextTick))
+        {
+            // the network thread is collecting them for us, so just wait
+            if (Pipelined)
+            {
+                ThreadSleep(ENET_TIME_DIFFERENCE(nextTick, now));
+                continue;
             }
 
-            case ENET_EVENT_TYPE_NONE:
-                break;
+            ENetEvent event = { 0 };
+
+            // wait for something to happen, but never longer than the time left in this tick
+            if (enet_host_service(server, &event, ENET_TIME_DIFFERENCE(nextTick, now)) > 0)
+            {
+                HandleEvent(&event, event.peer->connectID);
+
+                // enet_host_service reads everything waiting on the socket, but only gives us one event
+                // so drain the rest of them without waiting
+                while (enet_host_check_events(server, &event) > 0)
+                    HandleEvent(&event, event.peer->connectID);
             }
+            continue;
         }
+
+        // if we fell way behind (debugger, machine was asleep) don't try to run all the missed ticks, just start over from now
+        if (ENET_TIME_DIFFERENCE(now, nextTick) > tickInterval * 4)
+            nextTick = now;
+
+        CurrentTickTime = nextTick;
+        nextTick += tickInterval;
+
+        // handle everything the network threads got since the last tick
+        for (int i = 0; Pipelined && i < ShardCount; i++)
+        {
+            InboundEvent message;
+            while (SpscQueuePop(&Shards[i].InboundQueue, &message))
+            {
+                ENetEvent event = { 0 };
+                event.type = message.Type;
+                event.peer = message.Peer;
+                event.packet = message.Packet;
+                HandleEvent(&event, message.ConnectId);
+            }
+        }
+
+        // move the game forward and tell everyone about it
+        SimulateTick();
+        UpdateInterest();
+        SendWorldUpdates();
+
+        // push the batched messages and world updates out now, instead of waiting for the next service call
+        // with network threads, wake them up to send and flush them
+        if (Pipelined)
+            WakeNetworkThreads();
+        else
+            enet_host_flush(server);
+
+        if (CurrentTick % statusTicks == 0)
+            PrintStatus();
     }
 
     // cleanup
-    enet_host_destroy(server);
+    FreeShards();
+    WorkerPoolFree(&Workers);
     enet_deinitialize();
+    InterestGridFree(&Grid);
+    LagHistoryFree(&Rewind);
+    FreePlayers();
 
     return 0;
-}
\ No newline at end of file
+}
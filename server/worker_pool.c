@@ -0,0 +1,134 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// implementation of the worker pool
+
+#include "worker_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// take items from the job until there are none left
+static void RunItems(WorkerPool* pool, int worker)
+{
+    for (;;)
+    {
+        int start = (int)AtomicAdd(&pool->NextIndex, WORKER_POOL_BATCH);
+        if (start >= pool->Count)
+            return;
+
+        int end = start + WORKER_POOL_BATCH < pool->Count ? start + WORKER_POOL_BATCH : pool->Count;
+        for (int i = start; i < end; i++)
+            pool->Function(pool->Context, i, worker);
+    }
+}
+
+// what each pool thread runs, wait for a job, help with it, say we are done, and go back to waiting
+static void WorkerMain(void* argument)
+{
+    WorkerThread* thread = (WorkerThread*)argument;
+    WorkerPool* pool = thread->Pool;
+
+    for (;;)
+    {
+        SemaphoreWait(pool->Start);
+        if (!AtomicLoad(&pool->Running))
+            return;
+
+        RunItems(pool, thread->Index);
+        SemaphorePost(pool->Done);
+    }
+}
+
+bool WorkerPoolInit(WorkerPool* pool, int threadCount)
+{
+    memset(pool, 0, sizeof(WorkerPool));
+    if (threadCount <= 0)
+        return true;
+
+    pool->Start = SemaphoreCreate();
+    pool->Done = SemaphoreCreate();
+    pool->Threads = (WorkerThread*)calloc(threadCount, sizeof(WorkerThread));
+    if (pool->Start == NULL || pool->Done == NULL || pool->Threads == NULL)
+    {
+        WorkerPoolFree(pool);
+        return false;
+    }
+
+    pool->Running = 1;
+    for (int i = 0; i < threadCount; i++)
+    {
+        pool->Threads[i].Pool = pool;
+        pool->Threads[i].Index = i + 1;
+        if (!ThreadStart(&pool->Threads[i].Thread, WorkerMain, &pool->Threads[i]))
+        {
+            WorkerPoolFree(pool);
+            return false;
+        }
+
+        // only count the ones that started, so we only wait for them when we stop
+        pool->ThreadCount++;
+    }
+
+    return true;
+}
+
+void WorkerPoolFree(WorkerPool* pool)
+{
+    // wake everyone up with nothing to do, so they see they should exit
+    AtomicStore(&pool->Running, 0);
+    for (int i = 0; i < pool->ThreadCount; i++)
+        SemaphorePost(pool->Start);
+
+    for (int i = 0; i < pool->ThreadCount; i++)
+        ThreadJoin(&pool->Threads[i].Thread);
+
+    if (pool->Start != NULL)
+        SemaphoreFree(pool->Start);
+    if (pool->Done != NULL)
+        SemaphoreFree(pool->Done);
+    free(pool->Threads);
+    memset(pool, 0, sizeof(WorkerPool));
+}
+
+void WorkerPoolRun(WorkerPool* pool, WorkFunction function, void* context, int count)
+{
+    pool->Function = function;
+    pool->Context = context;
+    pool->Count = count;
+    AtomicStore(&pool->NextIndex, 0);
+
+    // the semaphore makes sure the threads see the job before they start on it
+    for (int i = 0; i < pool->ThreadCount; i++)
+        SemaphorePost(pool->Start);
+
+    RunItems(pool, 0);
+
+    for (int i = 0; i < pool->ThreadCount; i++)
+        SemaphoreWait(pool->Done);
+}
@@ -0,0 +1,85 @@
+/**********************************************************************************************
+*
+*   raylib_networking_smaple * a sample network game using raylib and enet
+*
+*   LICENSE: ZLIB
+*
+*   Copyright (c) 2021 Jeffery Myers
+*
+*   Permission is hereby granted, free of charge, to any person obtaining a copy
+*   of this software and associated documentation files (the "Software"), to deal
+*   in the Software without restriction, including without limitation the rights
+*   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*   copies of the Software, and to permit persons to whom the Software is
+*   furnished to do so, subject to the following conditions:
+*
+*   The above copyright notice and this permission notice shall be included in all
+*   copies or substantial portions of the Software.
+*
+*   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*   SOFTWARE.
+*
+**********************************************************************************************/
+
+// A pool of threads that run the same function for a range of items in parallel
+// The thread that starts the work helps with it, and it returns once every item is done.
+// Items are handed out a few at a time from a shared counter, so threads that get cheap items just take more of them.
+// Threads wait on a semaphore between jobs, so an idle pool does not use any CPU.
+#pragma once
+
+#include <stdbool.h>
+
+#include "threading.h"
+
+// how many items a thread takes from the counter at once
+#define WORKER_POOL_BATCH 8
+
+// the function run for each item
+// worker is which thread is running it, 0 is the thread that called WorkerPoolRun and the pool threads are 1 and up
+typedef void (*WorkFunction)(void* context, int index, int worker);
+
+struct WorkerPool;
+
+// one thread in the pool
+typedef struct
+{
+    Thread Thread;
+    struct WorkerPool* Pool;
+    int Index;
+}WorkerThread;
+
+// the threads and the job they are working on
+typedef struct WorkerPool
+{
+    int ThreadCount;
+    WorkerThread* Threads;
+
+    // posted once for each thread to start a job, and once by each thread when it has finished its share
+    Semaphore* Start;
+    Semaphore* Done;
+
+    // cleared to tell the threads to exit
+    volatile uint32_t Running;
+
+    // the job being run, and the next item that nobody has taken yet
+    WorkFunction Function;
+    void* Context;
+    int Count;
+    volatile uint32_t NextIndex;
+}WorkerPool;
+
+// start threadCount threads, a pool with 0 threads runs everything on the calling thread
+// returns false if the threads could not be started
+bool WorkerPoolInit(WorkerPool* pool, int threadCount);
+
+// stop the threads and release the pool
+void WorkerPoolFree(WorkerPool* pool);
+
+// run a function for every index from 0 to count - 1 across all the threads, and wait for them to finish
+// the items can run in any order, and at the same time as each other
+void WorkerPoolRun(WorkerPool* pool, WorkFunction function, void* context, int count);